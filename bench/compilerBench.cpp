@@ -0,0 +1,311 @@
+// Compiler throughput benchmark: generates Hexagn programs that grow along one
+// axis at a time and times tokenize(), compile() and the whole compiler() on
+// every size. Each size runs in a child process of its own, so its peak RSS
+// is not hidden by a larger run before it. The growth columns are the
+// exponent of each phase's time against the size, 1 being linear, so
+// quadratic behaviour shows up as values near 2
+//
+// Calls are only generated as statements, the expression parser does not
+// handle them inside expressions
+//
+// Usage: compilerBench [scale] [iterations]
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <functional>
+
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include <compiler/lexer.h>
+#include <compiler/parser.h>
+#include <compiler/linker.h>
+#include <compiler/compiler.h>
+#include <compiler/cacheFile.h>
+#include <importer/importHelper.h>
+#include <importer/libraryCache.h>
+
+// Sizes every axis runs at, as multiples of its base size
+static const size_t SIZE_STEPS[] = { 1, 2, 4, 8 };
+
+// Above this, a phase is flagged as growing faster than linearly
+constexpr double SUPERLINEAR_GROWTH = 1.5;
+
+struct Axis
+{
+	const char* name;
+	size_t baseSize;
+	// Program of the given size. Imported libraries are written under libDir
+	std::function<std::string(size_t, const std::filesystem::path&)> generate;
+};
+
+struct RunResult
+{
+	bool succeeded;
+	size_t tokens;
+	double tokenizeMs;
+	double compileMs;
+	double compilerMs;
+};
+
+static std::string generateFunctions(const size_t& count, const std::filesystem::path&)
+{
+	std::string src;
+	for (size_t i = 0; i < count; ++i)
+	{
+		src += "int32 f" + std::to_string(i) + "(int32 x)\n{\n";
+		if (i != 0)
+			src += "\tf" + std::to_string(i - 1) + "(x);\n";
+		src += "\tint32 r = x + 1;\n\treturn r;\n}\n\n";
+	}
+
+	src += "int8 main()\n{\n\tf" + std::to_string(count - 1) + "(1);\n}\n";
+	return src;
+}
+
+static std::string generateNesting(const size_t& depth, const std::filesystem::path&)
+{
+	std::string src = "int8 main()\n{\n\tint32 a = 0;\n";
+	for (size_t i = 0; i < depth; ++i)
+		src += (i % 2 == 0 ? "\tif (a < " : "\twhile (a < ") + std::to_string(i + 1) + ")\n\t{\n";
+	src += "\ta = a + 1;\n";
+	for (size_t i = 0; i < depth; ++i)
+		src += "\t}\n";
+	src += "}\n";
+	return src;
+}
+
+static std::string generateExpression(const size_t& terms, const std::filesystem::path&)
+{
+	static const char* const operators[] = { " + ", " - ", " * ", " / " };
+
+	std::string src = "int8 main()\n{\n\tint32 a = 3;\n\tint32 b = a";
+	for (size_t i = 0; i < terms; ++i)
+		src += operators[i % 4] + (i % 3 == 0 ? std::string("a") : std::to_string(i + 1));
+	src += ";\n}\n";
+	return src;
+}
+
+static std::string generateLocals(const size_t& count, const std::filesystem::path&)
+{
+	std::string src = "int8 main()\n{\n\tint32 v0 = 1;\n";
+	for (size_t i = 1; i < count; ++i)
+		src += "\tint32 v" + std::to_string(i) + " = v" + std::to_string(i - 1) + " + " + std::to_string(i) + ";\n";
+	src += "}\n";
+	return src;
+}
+
+static std::string generateStrings(const size_t& count, const std::filesystem::path&)
+{
+	std::string src = "int8 main()\n{\n";
+	for (size_t i = 0; i < count; ++i)
+		src += "\tstring s" + std::to_string(i) + " = \"generated string number " + std::to_string(i) + "\";\n";
+	src += "}\n";
+	return src;
+}
+
+static std::string generateImports(const size_t& count, const std::filesystem::path& libDir)
+{
+	std::string src;
+	std::string body = "int8 main()\n{\n\tint32 a = 0;\n";
+	for (size_t i = 0; i < count; ++i)
+	{
+		const std::string name = "lib" + std::to_string(i);
+		const std::filesystem::path dir = libDir / "benchlib" / name;
+		std::filesystem::create_directories(dir);
+
+		std::ofstream lib(dir / (name + ".hxgn"));
+		lib << "int32 " << name << "(int32 x)\n{\n\tint32 r = x + " << i << ";\n\treturn r;\n}\n";
+
+		src += "import benchlib." + name + ";\n";
+		body += "\t" + name + "(a);\n";
+	}
+
+	return src + '\n' + body + "}\n";
+}
+
+template<typename Body>
+static double bestOf(const size_t& iterations, const Body& body)
+{
+	double best = 0;
+	for (size_t i = 0; i < iterations; ++i)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		body();
+		const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+		if (i == 0 || elapsed.count() < best)
+			best = elapsed.count();
+	}
+	return best;
+}
+
+// Runs in the child process
+static RunResult runPhases(const std::string& text, const std::filesystem::path& workDir, const size_t& iterations)
+{
+	// Every run does the whole work instead of hitting an earlier run's cache
+	setCacheEnabled(false);
+	setLibraryCacheEnabled(false);
+
+	RunResult result { true, 0, 0, 0, 0 };
+	const SourceFile source(text);
+
+	std::vector<Token> toks;
+	result.tokenizeMs = bestOf(iterations, [&]()
+	{
+		Diagnostics diagnostics;
+		toks = tokenize(source, diagnostics);
+		result.succeeded &= !diagnostics.hasErrors();
+	});
+	result.tokens = toks.size();
+
+	result.compileMs = bestOf(iterations, [&]()
+	{
+		CompilerContext context;
+		addPath(context, workDir.string());
+		context.src = source;
+
+		Linker linker(context);
+		OutputBuffer code;
+		compile(context, code, linker, toks, false, true, true);
+		result.succeeded &= !context.diagnostics.hasErrors();
+	});
+
+	const std::string input = (workDir / "bench.hxgn").string();
+	const std::string output = (workDir / "bench.urcl").string();
+	std::ofstream(input) << text;
+
+	result.compilerMs = bestOf(iterations, [&]()
+	{
+		CompilerContext context;
+		addPath(context, workDir.string());
+		result.succeeded &= compiler(context, input, output, false, true);
+		if (context.diagnostics.hasErrors())
+			context.diagnostics.print(std::cerr);
+	});
+
+	return result;
+}
+
+// Runs one size in a child process, peakRssKiB is the peak of that process alone
+static bool runIsolated(const std::string& text, const std::filesystem::path& workDir, const size_t& iterations, RunResult& result, long& peakRssKiB)
+{
+	int fds[2];
+	if (pipe(fds) != 0)
+		return false;
+
+	std::cout.flush();
+	const pid_t pid = fork();
+	if (pid < 0)
+		return false;
+
+	if (pid == 0)
+	{
+		close(fds[0]);
+		const RunResult childResult = runPhases(text, workDir, iterations);
+		const bool written = write(fds[1], &childResult, sizeof(childResult)) == sizeof(childResult);
+		_exit(written ? 0 : 1);
+	}
+
+	close(fds[1]);
+	const bool received = read(fds[0], &result, sizeof(result)) == sizeof(result);
+	close(fds[0]);
+
+	int status;
+	rusage usage;
+	wait4(pid, &status, 0, &usage);
+	peakRssKiB = usage.ru_maxrss;
+
+	return received && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static std::string formatGrowth(const double& ms, const double& previousMs, const double& sizeRatio)
+{
+	if (previousMs <= 0 || ms <= 0)
+		return "-";
+
+	const double growth = std::log(ms / previousMs) / std::log(sizeRatio);
+
+	std::ostringstream out;
+	out << std::fixed << std::setprecision(2) << growth << (growth > SUPERLINEAR_GROWTH ? "!" : "");
+	return out.str();
+}
+
+int main(int argc, char* argv[])
+{
+	const size_t scale      = argc > 1 ? std::stoul(argv[1]) : 1;
+	const size_t iterations = argc > 2 ? std::stoul(argv[2]) : 3;
+
+	const std::vector<Axis> axes = {
+		{ "functions",  500, generateFunctions },
+		{ "nesting",     50, generateNesting },
+		{ "expression", 250, generateExpression },
+		{ "locals",     500, generateLocals },
+		{ "strings",    500, generateStrings },
+		{ "imports",     25, generateImports },
+	};
+
+	const std::filesystem::path workRoot = std::filesystem::temp_directory_path() / ("hexagnBench-" + std::to_string(getpid()));
+
+	std::cout << "Best of " << iterations << " iterations, growth is the time exponent against the previous size\n\n";
+	std::cout << std::left << std::setw(12) << "axis" << std::right
+			  << std::setw(8) << "size" << std::setw(9) << "lines" << std::setw(10) << "tokens"
+			  << std::setw(11) << "lex ms" << std::setw(11) << "Mtok/s"
+			  << std::setw(12) << "compile ms" << std::setw(11) << "full ms" << std::setw(12) << "klines/s"
+			  << std::setw(10) << "RSS MB" << "   growth lex/compile/full\n";
+
+	bool failed = false;
+	std::cout << std::fixed;
+
+	for (const Axis& axis: axes)
+	{
+		RunResult previous {};
+		size_t previousSize = 0;
+
+		for (const size_t& step: SIZE_STEPS)
+		{
+			const size_t size = axis.baseSize * scale * step;
+			const std::filesystem::path workDir = workRoot / (std::string(axis.name) + '-' + std::to_string(size));
+			std::filesystem::create_directories(workDir);
+
+			const std::string text = axis.generate(size, workDir);
+			const size_t lines = SourceFile(text).getLineCount();
+
+			RunResult result;
+			long peakRssKiB = 0;
+			if (!runIsolated(text, workDir, iterations, result, peakRssKiB) || !result.succeeded)
+			{
+				std::cout << std::left << std::setw(12) << axis.name << std::right << std::setw(8) << size << "   failed\n";
+				failed = true;
+				break;
+			}
+
+			const double sizeRatio = previousSize == 0 ? 0 : double(size) / previousSize;
+
+			std::cout << std::left << std::setw(12) << axis.name << std::right
+					  << std::setw(8) << size << std::setw(9) << lines << std::setw(10) << result.tokens
+					  << std::setprecision(2)
+					  << std::setw(11) << result.tokenizeMs << std::setw(11) << result.tokens / (result.tokenizeMs * 1000)
+					  << std::setw(12) << result.compileMs << std::setw(11) << result.compilerMs
+					  << std::setw(12) << lines / result.compilerMs
+					  << std::setprecision(1) << std::setw(10) << peakRssKiB / 1024.0 << "   "
+					  << formatGrowth(result.tokenizeMs, previous.tokenizeMs, sizeRatio) << '/'
+					  << formatGrowth(result.compileMs, previous.compileMs, sizeRatio) << '/'
+					  << formatGrowth(result.compilerMs, previous.compilerMs, sizeRatio) << '\n';
+
+			previous = result;
+			previousSize = size;
+		}
+	}
+
+	std::filesystem::remove_all(workRoot);
+	return failed ? -1 : 0;
+}
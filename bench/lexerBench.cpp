@@ -0,0 +1,138 @@
+// Lexer microbenchmark: tokenizes generated multi-megabyte sources with
+// every character scanning level the CPU supports and compares them
+// against the scalar path
+//
+// Usage: lexerBench [megabytes] [iterations]
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+
+#include <compiler/lexer.h>
+#include <compiler/charScan.h>
+
+static std::string generateSource(size_t targetSize)
+{
+	std::mt19937 rng(1337);
+	std::string src;
+	src.reserve(targetSize + 256);
+
+	const auto identifier = [&rng](size_t minLen, size_t maxLen)
+	{
+		static const char chars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789";
+		std::string id(1, chars[rng() % 26]);
+		const size_t len = minLen + rng() % (maxLen - minLen + 1);
+		while (id.size() < len)
+			id += chars[rng() % (sizeof(chars) - 1)];
+		return id;
+	};
+
+	size_t func = 0;
+	while (src.size() < targetSize)
+	{
+		src += "// Generated function " + std::to_string(func) + ", nothing to see here\n";
+		src += "void " + identifier(8, 24) + "_" + std::to_string(func++) + "(int32 argumentNumberOne, int32 argumentNumberTwo)\n{\n";
+
+		const size_t statements = 8 + rng() % 16;
+		for (size_t i = 0; i < statements; ++i)
+		{
+			src += std::string(1 + rng() % 3, '\t');
+			switch (rng() % 4)
+			{
+				case 0:
+					src += "int32 " + identifier(6, 20) + " = " + std::to_string(rng()) + " + argumentNumberOne * " + std::to_string(rng() % 100000) + ";\n";
+					break;
+				case 1:
+					src += "string " + identifier(6, 20) + " = \"" + identifier(20, 60) + " with some spaces in it    and\\ttabs\";\n";
+					break;
+				case 2:
+					src += "while (argumentNumberOne < " + std::to_string(rng() % 1000) + ") {\n\t\targumentNumberOne = argumentNumberOne + 1;\n\t}\n";
+					break;
+				default:
+					src += "urcl \"" + identifier(10, 40) + "\";        // trailing comment about " + identifier(10, 40) + "\n";
+					break;
+			}
+		}
+
+		src += "}\n\n";
+	}
+
+	return src;
+}
+
+static const char* levelName(ScanLevel level)
+{
+	switch (level)
+	{
+		case ScanLevel::SCALAR: return "scalar";
+		case ScanLevel::SSE2:   return "sse2";
+		case ScanLevel::AVX2:   return "avx2";
+		default:                return "unknown";
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const size_t megabytes  = argc > 1 ? std::stoul(argv[1]) : 8;
+	const size_t iterations = argc > 2 ? std::stoul(argv[2]) : 5;
+
+	const SourceFile source(generateSource(megabytes * 1024 * 1024));
+	const double sizeMB = source.getSource().size() / (1024.0 * 1024.0);
+
+	std::cout << "Source: " << std::fixed << std::setprecision(2) << sizeMB << " MB, "
+			  << source.getLineCount() << " lines, " << iterations << " iterations\n\n";
+
+	std::vector<ScanLevel> levels = { ScanLevel::SCALAR };
+	if (getBestScanLevel() >= ScanLevel::SSE2) levels.push_back(ScanLevel::SSE2);
+	if (getBestScanLevel() >= ScanLevel::AVX2) levels.push_back(ScanLevel::AVX2);
+
+	std::vector<Token> reference;
+	double scalarTime = 0;
+
+	std::cout << std::left << std::setw(10) << "level" << std::right
+			  << std::setw(12) << "best ms" << std::setw(12) << "MB/s" << std::setw(14) << "tokens" << std::setw(10) << "speedup" << '\n';
+
+	for (const ScanLevel& level: levels)
+	{
+		setScanLevel(level);
+
+		double best = 0;
+		std::vector<Token> toks;
+		Diagnostics diagnostics;
+		for (size_t i = 0; i < iterations; ++i)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			toks = tokenize(source, diagnostics);
+			const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+			if (i == 0 || elapsed.count() < best)
+				best = elapsed.count();
+		}
+
+		if (level == ScanLevel::SCALAR)
+		{
+			reference = toks;
+			scalarTime = best;
+		}
+		else
+		{
+			bool same = toks.size() == reference.size();
+			for (size_t i = 0; same && i < toks.size(); ++i)
+				same = toks[i].m_type == reference[i].m_type && toks[i].m_val == reference[i].m_val
+					&& toks[i].m_lineno == reference[i].m_lineno && toks[i].m_start == reference[i].m_start;
+
+			if (!same)
+			{
+				std::cerr << "Error: " << levelName(level) << " tokens differ from the scalar lexer\n";
+				return -1;
+			}
+		}
+
+		std::cout << std::left << std::setw(10) << levelName(level) << std::right
+				  << std::setw(12) << best << std::setw(12) << sizeMB / (best / 1000)
+				  << std::setw(14) << toks.size() << std::setw(9) << scalarTime / best << "x\n";
+	}
+}
@@ -0,0 +1,20 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <server.h>
+
+// Compiles every input with the same flags, at most jobs at a time. Library
+// files on the search paths are parsed once up front, then the inputs are
+// compiled on threads of this process, each with a context of its own. With
+// forkWorkers every input is compiled in a forked worker instead, so even a
+// crash only fails its own input. Outputs go next to the inputs, or into
+// outputDir if it is not empty. An input whose output file another input
+// already writes fails. Results and diagnostics are reported in input order.
+// Returns 0 if every input compiled
+int runBatch(const std::vector<std::string>& inputs, const std::string& outputDir, const size_t& jobs, const bool& forkWorkers, const std::vector<std::string>& flags, CommandLineHandler handler);
+
+#endif // BATCH_H
@@ -0,0 +1,79 @@
+#ifndef AST_H
+#define AST_H
+
+#include <cstdint>
+#include <vector>
+
+#include <compiler/token.h>
+#include <compiler/sourceFile.h>
+#include <compiler/diagnostics.h>
+
+typedef uint32_t TokenIndex;
+typedef uint32_t NodeIndex;
+
+constexpr NodeIndex NO_NODE = NodeIndex(-1);
+
+enum class NodeType: uint8_t
+{
+	NT_VAR_DEFINITION,  // type name = expr;
+	NT_VAR_DECLARATION, // type name;
+	NT_FUNCTION,        // type name(params) { body }
+	NT_PARAMETER,       // type name
+	NT_ASSIGNMENT,      // name = expr;
+	NT_CALL,            // name(args)
+	NT_ARGUMENT,        // identifier, number or string
+	NT_IF,              // if (lhs op rhs) { body }
+	NT_WHILE,           // while (lhs op rhs) { body }
+	NT_IMPORT,          // import module.submodule:file;
+	NT_URCL_BLOCK,      // urcl "code";
+	NT_RETURN,          // return expr;
+};
+
+// Nodes never copy tokens, they refer to them by index into the token vector
+// the tree was parsed from. Which fields are used depends on the node type
+struct Node
+{
+	NodeType type;
+
+	// Token the node starts with: type, identifier, keyword or argument
+	TokenIndex token;
+	// Identifier of definitions and parameters, comparison operator of conditions
+	TokenIndex name;
+	// Operands of if/while conditions, string of urcl blocks (lhs)
+	TokenIndex lhs;
+	TokenIndex rhs;
+
+	// Expression or import name tokens, every token of a function definition, [begin, end)
+	TokenIndex begin;
+	TokenIndex end;
+
+	// Parameters of a function, arguments of a call
+	NodeIndex list;
+	// Statements of a function, if or while body
+	NodeIndex body;
+
+	NodeIndex next;
+};
+
+struct Ast
+{
+	const std::vector<Token>& tokens;
+
+	// Every node of the tree lives in here, links between them are indices so it can grow freely
+	std::vector<Node> nodes;
+
+	// First top level statement
+	NodeIndex root = NO_NODE;
+
+	const Node& operator[](const NodeIndex& index) const
+	{
+		return nodes[index];
+	}
+};
+
+// Builds the tree in a single pass over the tokens. Syntax errors are reported
+// to diagnostics quoting src, the source the tokens were lexed from, and parsing
+// carries on with the next statement. A tree with errors is not fit for code generation
+Ast parseAst(const SourceFile& src, const std::vector<Token>& tokens, Diagnostics& diagnostics);
+
+#endif // AST_H
@@ -0,0 +1,104 @@
+#ifndef CACHE_FILE_H
+#define CACHE_FILE_H
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <compiler/token.h>
+
+// Helpers shared by the on-disk caches of library files and function bodies
+
+// Turns every cache off, for --no-cache
+void setCacheEnabled(const bool& enabled);
+bool isCacheEnabled();
+
+// Root of all cache files, empty if the platform has no place for them
+const std::filesystem::path& getCacheDirectory();
+// <dir>/<16 hex digits of key><extension>
+std::filesystem::path getCacheFile(const std::filesystem::path& dir, const uint64_t& key, const char* extension);
+
+// Written under a temporary name and renamed, so concurrent compiles never see half a file
+void writeCacheFile(const std::filesystem::path& file, std::string_view data);
+
+// Read-only view of a whole file, memory mapped where the platform has mmap
+class MappedFile
+{
+private:
+	std::string_view m_data;
+#ifdef _WIN32
+	std::string m_buffer;
+#endif
+
+public:
+	MappedFile(const std::filesystem::path& file);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator =(const MappedFile&) = delete;
+
+	std::string_view data() const
+	{
+		return m_data;
+	}
+};
+
+template <typename T>
+void writeValue(std::string& out, const T& value)
+{
+	out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void writeString(std::string& out, std::string_view str);
+void writeToken(std::string& out, const Token& tok);
+void writeTokens(std::string& out, const std::vector<Token>& toks);
+
+// Bounds checked reads of a cache file, any read past the end marks the whole file as unusable
+class CacheReader
+{
+private:
+	std::string_view m_data;
+	bool m_valid = true;
+
+public:
+	CacheReader(std::string_view data)
+		: m_data(data)
+	{}
+
+	bool isValid() const
+	{
+		return m_valid;
+	}
+
+	bool atEnd() const
+	{
+		return m_data.empty();
+	}
+
+	template <typename T>
+	T read()
+	{
+		T value {};
+		if (m_data.size() < sizeof(T))
+		{
+			m_valid = false;
+			m_data = {};
+			return value;
+		}
+
+		std::memcpy(&value, m_data.data(), sizeof(T));
+		m_data.remove_prefix(sizeof(T));
+		return value;
+	}
+
+	std::string_view readString();
+
+	// Cached tokens have no position, like the ones parseURCLSource makes
+	Token readToken();
+	std::vector<Token> readTokens();
+};
+
+#endif // CACHE_FILE_H
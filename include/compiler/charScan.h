@@ -0,0 +1,32 @@
+#ifndef CHAR_SCAN_H
+#define CHAR_SCAN_H
+
+#include <string_view>
+
+// Character class scanning for the lexer. Every scan starts at pos and
+// returns the index of the first character that does not belong to the
+// run, or data.size() if the run reaches the end of the data
+
+enum class ScanLevel
+{
+	SCALAR,
+	SSE2,
+	AVX2
+};
+
+// Spaces, tabs and carriage returns, newlines end the run since the lexer counts lines
+size_t scanBlanks(std::string_view data, size_t pos);
+// Identifier characters [A-Za-z0-9_-]
+size_t scanWord(std::string_view data, size_t pos);
+// Decimal digits
+size_t scanDigits(std::string_view data, size_t pos);
+// String literal contents, the run ends at '"', '\\' or a newline
+size_t scanStringBody(std::string_view data, size_t pos);
+
+// The best level the running CPU supports is picked on startup
+ScanLevel getScanLevel();
+ScanLevel getBestScanLevel();
+// Levels above getBestScanLevel() are clamped to it
+void setScanLevel(ScanLevel level);
+
+#endif // CHAR_SCAN_H
@@ -0,0 +1,45 @@
+#ifndef COMPILE_CACHE_H
+#define COMPILE_CACHE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <compiler/outputBuffer.h>
+
+// Whole-output cache in front of the compiler. A compile is keyed by its
+// source, flags and library search paths, and its entry lists every library
+// file, library directory and missing search path the imports looked at.
+// The cached output is only used while all of them still look the same
+
+// Files and directories one compile's imports looked at, safe to record from concurrent imports
+class CompileDependencies
+{
+private:
+	// Hash of the contents, or of the listing for directories, for every kind and path.
+	// Ordered, so the same compile always writes the same entry
+	std::map<std::pair<uint8_t, std::string>, uint64_t> m_hashes;
+	mutable std::mutex m_mutex;
+
+	void record(const uint8_t& kind, const std::filesystem::path& path, const uint64_t& hash);
+
+public:
+	void recordFile(const std::filesystem::path& file, std::string_view contents);
+	// files are the sorted non-directory entries of dir
+	void recordDirectory(const std::filesystem::path& dir, const std::vector<std::filesystem::path>& files);
+	void recordMissing(const std::filesystem::path& path);
+
+	void write(std::string& out) const;
+};
+
+uint64_t getCompileKey(const std::vector<std::filesystem::path>& libPaths, std::string_view source, const bool& debugSymbols, const bool& emitEntryPoint);
+// Output of an earlier compile with the same key whose dependencies are all unchanged
+bool loadCompileCache(const uint64_t& key, OutputBuffer& code);
+void storeCompileCache(const uint64_t& key, const CompileDependencies& dependencies, const OutputBuffer& code);
+
+#endif // COMPILE_CACHE_H
@@ -3,6 +3,15 @@
 
 #include <string>
 
-void compiler(const std::string& inputFileName, const std::string& outputFileName, const bool& debugSymbols, const bool& emitEntryPoint);
+#include <compiler/compilerContext.h>
+#include <compiler/outputBuffer.h>
+
+// Every compile needs a context of its own, set up with the library search paths to use.
+// Returns false if the compile failed, every error it ran into is in context.diagnostics
+bool compiler(CompilerContext& context, const std::string& inputFileName, const std::string& outputFileName, const bool& debugSymbols, const bool& emitEntryPoint);
+
+// Compiles context.src, which the caller has filled in, into code without
+// touching any input or output file. Returns false like compiler does
+bool compileSource(CompilerContext& context, OutputBuffer& code, const bool& debugSymbols, const bool& emitEntryPoint);
 
 #endif // COMPILER_H
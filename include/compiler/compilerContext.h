@@ -0,0 +1,57 @@
+#ifndef COMPILER_CONTEXT_H
+#define COMPILER_CONTEXT_H
+
+#include <cstddef>
+#include <filesystem>
+#include <vector>
+
+#include <compiler/sourceFile.h>
+#include <compiler/string.h>
+#include <compiler/compileCache.h>
+#include <compiler/diagnostics.h>
+#include <compiler/timeReport.h>
+#include <compiler/memReport.h>
+
+class MemoryLibrary;
+
+// Numbers of the if and while labels, they keep counting through every file of the compile
+struct LabelCounters
+{
+	size_t ifCount = 0;
+	size_t whileCount = 0;
+};
+
+// Everything one compile owns. Compiles with their own context only share
+// process-wide caches that are safe to use concurrently, so any number of
+// them can run in one process, one after another or on separate threads
+struct CompilerContext
+{
+	// File being compiled, which diagnostics and -g output quote. Imported Hexagn files swap in their own
+	SourceFile src;
+
+	LabelCounters labels;
+	StringTable strings;
+
+	// Where imports are searched, in order
+	std::vector<std::filesystem::path> libPaths;
+	// Library files imports are looked up in instead of libPaths when set, nothing is read from disk then
+	const MemoryLibrary* memoryLibrary = nullptr;
+	// Protection against importing same file twice
+	std::vector<std::filesystem::path> imported;
+
+	CompileDependencies dependencies;
+	// Every error of the compile, imported files included
+	Diagnostics diagnostics;
+	// Phases are timed into it when set, for -ftime-report
+	TimeReport* timeReport = nullptr;
+	// Sizes of the compile are recorded into it when set, for -fmem-report
+	MemReport* memReport = nullptr;
+
+	// Starts with the default library search paths
+	CompilerContext();
+
+	CompilerContext(const CompilerContext&) = delete;
+	CompilerContext& operator =(const CompilerContext&) = delete;
+};
+
+#endif // COMPILER_CONTEXT_H
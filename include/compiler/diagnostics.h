@@ -0,0 +1,53 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <compiler/token.h>
+#include <compiler/sourceFile.h>
+
+// Thrown once an error has been reported, to give up on the statement it was
+// found in. Whoever catches it carries on with the next statement
+struct CompileError {};
+
+// One reported error. Errors that are not about a place in the source have a lineno of 0
+struct Diagnostic
+{
+	// Printed text, with the line quoted
+	std::string text;
+	std::string message;
+	size_t lineno = 0;
+	size_t start = 0;
+	size_t end = 0;
+};
+
+// Errors of one compile in the order they were reported. Nothing is printed
+// until the caller asks for it, so a failed compile leaves the process running
+class Diagnostics
+{
+private:
+	std::vector<Diagnostic> m_errors;
+	// Imports of library files report from concurrent loads
+	mutable std::mutex m_mutex;
+
+public:
+	// text is printed as is
+	void error(const std::string& text);
+	// "message at line n", then the line quoted with arrows under columns start to end
+	void error(const SourceFile& src, const std::string& message, const size_t& lineno, const size_t& start, const size_t& end);
+	void error(const SourceFile& src, const std::string& message, const Token& tok);
+
+	// Adds the errors of other after the ones reported so far
+	void append(const Diagnostics& other);
+
+	std::vector<Diagnostic> getErrors() const;
+	size_t getErrorCount() const;
+	bool hasErrors() const;
+	void print(std::ostream& out) const;
+};
+
+#endif // DIAGNOSTICS_H
@@ -0,0 +1,59 @@
+#ifndef FUNCTION_CACHE_H
+#define FUNCTION_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <compiler/token.h>
+
+// Generated function bodies are cached in the user cache directory, keyed by
+// a hash of the function's tokens and the flags that change its code. Label
+// and string numbers depend on the rest of the program, so they are cut out
+// of the cached code and filled in again when it is reused
+
+enum class RelocationType: uint8_t
+{
+	RT_IF_LABEL,
+	RT_WHILE_LABEL,
+	RT_STRING_LABEL
+};
+
+// A label or string number written into generated code
+struct Relocation
+{
+	// Where the number goes in the code
+	size_t offset;
+	RelocationType type;
+	// Generated code holds absolute numbers. Cached code holds if and while numbers
+	// relative to the function's first label, and indices into CachedFunction::strings
+	size_t number;
+	// Raw literal of a string number, only set in generated code
+	std::string_view string = {};
+};
+
+// A call made by a cached body, it has to resolve to the same function for the entry to be used
+struct CachedCall
+{
+	std::string name;
+	std::vector<TokenType> argTypes;
+	std::string signature;
+};
+
+struct CachedFunction
+{
+	// Code with the relocated numbers left out
+	std::string code;
+	std::vector<Relocation> relocations;
+	// Raw string literals the body uses
+	std::vector<std::string> strings;
+	// In the order the body makes them
+	std::vector<CachedCall> calls;
+};
+
+// Both are safe to call from concurrent body generation
+bool loadFunctionCache(const uint64_t& key, CachedFunction& function);
+void storeFunctionCache(const uint64_t& key, const CachedFunction& function);
+
+#endif // FUNCTION_CACHE_H
@@ -0,0 +1,161 @@
+#ifndef IR_H
+#define IR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <compiler/token.h>
+#include <compiler/outputBuffer.h>
+#include <compiler/functionCache.h>
+
+// Three-address code that function bodies and the top level code are lowered
+// to before URCL is printed from them. Values live in numbered virtual
+// registers, which print as the URCL register of the same number. R1 holds
+// the frame, so they start at 2. Variables are stack slots next to the frame,
+// only reached through explicit loads and stores
+
+enum class IrOp: uint8_t
+{
+	IR_IMM,      // dst = a
+	IR_MOV,      // dst = a, a register or the address of a label
+	IR_LOAD,     // dst = slot a
+	IR_STORE,    // slot a = b
+	IR_PUSH,     // a new stack slot = a
+	IR_ALLOC,    // a new stack slot, left uninitialised
+	IR_FREE,     // drops the last a stack slots
+
+	// dst = a op b
+	IR_ADD,
+	IR_SUB,
+	IR_MLT,
+	IR_DIV,
+	IR_MOD,
+	IR_AND,
+
+	IR_CALL,     // calls function a, its arguments pushed before it in reverse order
+	IR_RET,      // leaves the function, the return value is in R2
+	IR_JMP,      // to label dst
+	IR_BRANCH,   // to label dst if a cond b holds, otherwise on to the next block
+
+	IR_URCL,     // inline URCL block, a is its text
+	IR_COMMENT   // source line quoted by -g output, a is its text
+};
+
+// Condition of IR_BRANCH
+enum class IrCond: uint8_t
+{
+	IC_EQ,
+	IC_NE,
+	IC_GT,
+	IC_GE,
+	IC_LT,
+	IC_LE
+};
+
+enum class IrOperandKind: uint8_t
+{
+	IO_NONE,
+	IO_REG,      // Virtual register number
+	IO_IMM,      // Immediate, as written in the source
+	IO_FLOAT,    // Float immediate, as written in the source
+	IO_LOCAL,    // Stack slot of a local, number is its offset below the frame
+	IO_ARG,      // Stack slot of an argument, number is its offset from getOffset
+	IO_COUNT,    // Number of stack slots
+	IO_LABEL
+};
+
+enum class IrLabelKind: uint8_t
+{
+	IL_IF,
+	IL_ENDIF,
+	IL_WHILE,
+	IL_ENDWHILE,
+	IL_STRING,   // Data of a string literal, text is the raw literal
+	IL_FUNCTION  // Entry of a function, text is its signature
+};
+
+struct IrOperand
+{
+	IrOperandKind kind = IrOperandKind::IO_NONE;
+	IrLabelKind label = IrLabelKind::IL_IF;
+	size_t number = 0;
+	// Views into the source, a label, or text kept by the body
+	std::string_view text = {};
+};
+
+IrOperand irReg(const size_t& reg);
+IrOperand irImm(std::string_view imm);
+IrOperand irFloat(std::string_view imm);
+IrOperand irLocal(const size_t& offset);
+IrOperand irArg(const size_t& offset);
+IrOperand irCount(const size_t& count);
+IrOperand irLabel(const IrLabelKind& kind, const size_t& number);
+IrOperand irString(const size_t& number, std::string_view string);
+IrOperand irFunction(std::string_view signature);
+IrOperand irText(std::string_view text);
+
+// Data type of a value, as the token type of its keyword and its width in bits.
+// Expressions are not typed any closer than an integer of width 0, a machine word
+struct IrType
+{
+	TokenType base = TokenType::TT_VOID;
+	uint8_t width = 0;
+};
+
+constexpr IrType IR_WORD = { TokenType::TT_INT, 0 };
+
+// Type of values of a data type token
+IrType getIrType(const Token& dataType);
+
+struct IrInstruction
+{
+	IrOp op;
+	// Of the value written to dst or pushed
+	IrType type = {};
+	IrOperand dst = {};
+	IrOperand a = {};
+	IrOperand b = {};
+	IrCond cond = IrCond::IC_EQ;
+
+	// URCL output separates statements with an empty line after their last instruction
+	bool blankLine = false;
+};
+
+// Starts with its label, if it has one, and only ends in a branch, jump or return.
+// A block that does not end in a jump falls through to the next one
+struct IrBlock
+{
+	IrOperand label;
+	std::vector<IrInstruction> instructions;
+};
+
+struct IrBody
+{
+	// In layout order
+	std::vector<IrBlock> blocks;
+	// Text of operands that is not in the source, like computed immediates
+	std::deque<std::string> texts;
+
+	// Appends to the last block, or to a new one if the last block has ended
+	void append(const IrInstruction& instruction);
+	void append(const std::vector<IrInstruction>& instructions);
+	// Starts a new block at label
+	void addLabel(const IrOperand& label);
+
+	// Marks the last instruction as the end of a statement
+	void endStatement();
+
+	// Keeps text alive for as long as the body
+	std::string_view addText(std::string text);
+
+	void clear();
+};
+
+// Prints the body as URCL. Label and string numbers it writes are recorded in relocations
+void printIr(const IrBody& body, OutputBuffer& code, std::vector<Relocation>& relocations);
+
+#endif // IR_H
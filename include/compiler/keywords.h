@@ -0,0 +1,116 @@
+#ifndef KEYWORDS_H
+#define KEYWORDS_H
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+#include <compiler/token.h>
+
+struct Keyword
+{
+	std::string_view word;
+	TokenType type;
+
+	// Bit width of sized data types, 0 for everything else
+	uint8_t width;
+	// Name mangling code of data types, empty for everything else
+	std::string_view mangled;
+};
+
+constexpr Keyword KEYWORDS[] =
+{
+	{ "void",    TokenType::TT_VOID,       0,  "v"   },
+
+	{ "int8",    TokenType::TT_INT,        8,  "i8"  },
+	{ "int16",   TokenType::TT_INT,        16, "i16" },
+	{ "int32",   TokenType::TT_INT,        32, "i32" },
+	{ "int64",   TokenType::TT_INT,        64, "i64" },
+
+	{ "uint8",   TokenType::TT_UINT,       8,  "u8"  },
+	{ "uint16",  TokenType::TT_UINT,       16, "u16" },
+	{ "uint32",  TokenType::TT_UINT,       32, "u32" },
+	{ "uint64",  TokenType::TT_UINT,       64, "u64" },
+
+	{ "float32", TokenType::TT_FLOAT,      32, "f32" },
+	{ "float64", TokenType::TT_FLOAT,      64, "f64" },
+
+	{ "string",  TokenType::TT_STRING,     0,  "s"   },
+	{ "char",    TokenType::TT_CHARACTER,  0,  "c"   },
+
+	{ "if",      TokenType::TT_IF,         0,  ""    },
+	{ "else",    TokenType::TT_ELSE,       0,  ""    },
+	{ "while",   TokenType::TT_WHILE,      0,  ""    },
+	{ "import",  TokenType::TT_IMPORT,     0,  ""    },
+	{ "urcl",    TokenType::TT_URCL_BLOCK, 0,  ""    },
+	{ "return",  TokenType::TT_RETURN,     0,  ""    },
+};
+
+constexpr size_t KEYWORD_COUNT = sizeof(KEYWORDS) / sizeof(KEYWORDS[0]);
+constexpr size_t KEYWORD_SLOTS = 64;
+
+constexpr uint32_t keywordHash(std::string_view word, uint32_t seed)
+{
+	// FNV-1a with a seeded offset basis
+	uint32_t hash = 2166136261u ^ seed;
+	for (const char& c: word)
+	{
+		hash ^= uint8_t(c);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+// Searches for a seed that gives every keyword its own slot, at compile time
+constexpr uint32_t findKeywordSeed()
+{
+	for (uint32_t seed = 0; seed < 100000; ++seed)
+	{
+		bool used[KEYWORD_SLOTS] = {};
+		bool collision = false;
+
+		for (const Keyword& keyword: KEYWORDS)
+		{
+			const size_t slot = keywordHash(keyword.word, seed) % KEYWORD_SLOTS;
+			if (used[slot])
+			{
+				collision = true;
+				break;
+			}
+			used[slot] = true;
+		}
+
+		if (!collision)
+			return seed;
+	}
+
+	return uint32_t(-1);
+}
+
+constexpr uint32_t KEYWORD_SEED = findKeywordSeed();
+static_assert(KEYWORD_SEED != uint32_t(-1), "No perfect hash seed found for the keyword table");
+
+constexpr std::array<int8_t, KEYWORD_SLOTS> buildKeywordSlots()
+{
+	std::array<int8_t, KEYWORD_SLOTS> slots {};
+	slots.fill(-1);
+
+	for (size_t i = 0; i < KEYWORD_COUNT; ++i)
+		slots[keywordHash(KEYWORDS[i].word, KEYWORD_SEED) % KEYWORD_SLOTS] = int8_t(i);
+
+	return slots;
+}
+
+constexpr std::array<int8_t, KEYWORD_SLOTS> KEYWORD_TABLE = buildKeywordSlots();
+
+// Looks up a keyword or data type name with a single probe, nullptr if the word is neither
+constexpr const Keyword* findKeyword(std::string_view word)
+{
+	const int8_t index = KEYWORD_TABLE[keywordHash(word, KEYWORD_SEED) % KEYWORD_SLOTS];
+	if (index < 0 || KEYWORDS[index].word != word)
+		return nullptr;
+
+	return &KEYWORDS[index];
+}
+
+#endif // KEYWORDS_H
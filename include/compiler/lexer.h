@@ -5,7 +5,10 @@
 #include <vector>
 
 #include <compiler/token.h>
+#include <compiler/sourceFile.h>
+#include <compiler/diagnostics.h>
 
-std::vector<Token> tokenize(std::string source);
+// Errors are reported to diagnostics and the rest of their line is skipped
+std::vector<Token> tokenize(const SourceFile& source, Diagnostics& diagnostics);
 
 #endif // LEXER_H
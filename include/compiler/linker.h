@@ -1,20 +1,60 @@
 #ifndef LINKER_H
 #define LINKER_H
 
+#include <shared_mutex>
 #include <vector>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 
 #include <compiler/token.h>
+#include <compiler/sourceFile.h>
+#include <compiler/outputBuffer.h>
+#include <compiler/diagnostics.h>
+#include <compiler/compilerContext.h>
 
 struct Function;
 
 class Linker
 {
 private:
+	// Compile the functions belong to, duplicate definitions are reported to it against its current source
+	CompilerContext& context;
+
+	// In definition order, which is the order functions are emitted in
 	std::vector<Function> linkerFunctions;
 
+	// Index into linkerFunctions for every mangled signature
+	std::unordered_map<std::string, size_t> signatureIndex;
+	// Indices of the overloads of a name bucketed by arity, each bucket in definition order.
+	// Keys view interned token text
+	std::unordered_map<std::string_view, std::vector<std::vector<size_t>>> nameIndex;
+
+	// Resolved function index for every name and argument type combination that was called.
+	// New functions only ever go after existing overloads, so entries never become stale.
+	// Function bodies are generated concurrently and mostly look up calls that were
+	// already resolved, so it is guarded by resolutionMutex, taken exclusively only to add
+	mutable std::unordered_map<std::string, size_t> resolutionCache;
+	mutable std::shared_mutex resolutionMutex;
+
+	const std::vector<size_t>* getOverloads(std::string_view name, const size_t& arity) const;
+
 public:
-	void addFunction(const Function& function);
-	const Function getFunction(const std::string& src, const Token& name, const std::vector<Token>& argTypes) const;
+	Linker(CompilerContext& context);
+
+	// Returns the index of the function in getFunctions(). A clash with an earlier
+	// definition is reported and the index of that definition returned instead
+	size_t addFunction(const Function& function);
+	// Code of functions declared before their bodies were generated
+	void setFunctionCode(const size_t& index, const OutputBuffer& code);
+
+	// Only the first visibleCount functions are considered, the ones that were declared before the call.
+	// Reports the call quoting src and throws CompileError when no overload accepts the arguments
+	const Function& getFunction(Diagnostics& diagnostics, const SourceFile& src, const Token& name, const std::vector<Token>& argTypes, const size_t& visibleCount = size_t(-1)) const;
+	// Like getFunction, but returns nullptr instead of reporting an error when no overload accepts the arguments
+	const Function* findFunction(const Token& name, const std::vector<Token>& argTypes, const size_t& visibleCount = size_t(-1)) const;
+	// Drops every function added after the first count, undoing a partially applied import
+	void removeFunctionsFrom(const size_t& count);
 	const std::vector<Function>& getFunctions() const;
 
 };
@@ -0,0 +1,55 @@
+#ifndef MEM_REPORT_H
+#define MEM_REPORT_H
+
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include <compiler/token.h>
+#include <compiler/string.h>
+
+struct Function;
+
+// Sizes of what a compile holds, for -fmem-report. Allocations are counted
+// by the replacement operator new while a report exists, under the phase
+// the allocating thread is in. The counters are process wide, so only the
+// first of several live reports counts them, and it also counts the
+// allocations of any other compile running meanwhile
+class MemReport
+{
+private:
+	size_t m_tokens = 0;
+	// Bytes of source text the tokens point at
+	size_t m_tokenTextBytes = 0;
+	size_t m_peakLocals = 0;
+	size_t m_functions = 0;
+	size_t m_functionCodeBytes = 0;
+	size_t m_strings = 0;
+	size_t m_stringBytes = 0;
+
+	// False if another report was already counting allocations when this one was made
+	bool m_countsAllocations = false;
+
+	// Function bodies are generated concurrently
+	mutable std::mutex m_mutex;
+
+public:
+	// Starts counting allocations from zero, unless another report is counting them
+	MemReport();
+	~MemReport();
+
+	MemReport(const MemReport&) = delete;
+	MemReport& operator =(const MemReport&) = delete;
+
+	void addTokens(const std::vector<Token>& tokens);
+	// Most variables a body had in scope at once
+	void addLocals(const size_t& peak);
+	// Functions and strings the output is written from
+	void setOutput(const std::vector<Function>& functions, const StringTable& strings);
+
+	// Sizes, peak RSS and the allocations of every phase
+	void print(std::ostream& out) const;
+};
+
+#endif // MEM_REPORT_H
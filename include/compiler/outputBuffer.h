@@ -0,0 +1,64 @@
+#ifndef OUTPUT_BUFFER_H
+#define OUTPUT_BUFFER_H
+
+#include <charconv>
+#include <concepts>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Generated code is appended to a rope of blocks instead of one contiguous
+// string. Copying or appending a whole buffer shares its blocks instead of
+// copying the bytes, and blocks that are shared are never written to again
+class OutputBuffer
+{
+private:
+	// Blocks start small so the code of tiny functions does not pin large
+	// allocations, and double up to the size of a large write
+	static constexpr size_t MIN_BLOCK_SIZE = 256;
+
+	struct Chunk
+	{
+		std::shared_ptr<char[]> data;
+		// Bytes of the block that belong to this buffer
+		size_t size;
+		size_t capacity;
+	};
+
+	std::vector<Chunk> m_chunks;
+	size_t m_size = 0;
+	size_t m_nextCapacity = MIN_BLOCK_SIZE;
+
+	// Last block if this buffer alone owns it and it has room left, otherwise a new block of at least needed bytes
+	Chunk& writableChunk(const size_t& needed);
+
+public:
+	void append(std::string_view str);
+	// Shares the blocks of the other buffer without copying them
+	void append(const OutputBuffer& other);
+
+	OutputBuffer& operator <<(std::string_view str)   { append(str); return *this; }
+	OutputBuffer& operator <<(const char* str)        { append(str); return *this; }
+	OutputBuffer& operator <<(const std::string& str) { append(str); return *this; }
+	OutputBuffer& operator <<(const OutputBuffer& other) { append(other); return *this; }
+	OutputBuffer& operator <<(const char& c)          { append(std::string_view(&c, 1)); return *this; }
+
+	template <std::integral T>
+	OutputBuffer& operator <<(const T& value)
+	{
+		char digits[24];
+		const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+		append(std::string_view(digits, result.ptr - digits));
+		return *this;
+	}
+
+	size_t size() const;
+	std::string toString() const;
+
+	// Writes every block with its own fwrite call, false if a write failed
+	bool writeTo(std::FILE* file) const;
+};
+
+#endif // OUTPUT_BUFFER_H
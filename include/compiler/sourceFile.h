@@ -0,0 +1,36 @@
+#ifndef SOURCE_FILE_H
+#define SOURCE_FILE_H
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Owns a source buffer along with the offset at which every line starts,
+// so line and column lookups do not have to rescan the source for newlines.
+// The buffer is immutable and shared between copies, so tokens can keep
+// views into it no matter where the SourceFile itself is moved to
+class SourceFile
+{
+private:
+	std::shared_ptr<const std::string> m_src;
+	std::vector<size_t> m_lineStarts;
+
+public:
+	SourceFile();
+	SourceFile(std::string src);
+
+	const std::string& getSource() const;
+	size_t getLineCount() const;
+
+	// Lines are 1-indexed, columns are 0-indexed offsets from the line start
+	size_t getLineStart(const size_t& lineno) const;
+	size_t getColumn(const size_t& pos, const size_t& lineno) const;
+	std::string_view getLine(const size_t& lineno) const;
+};
+
+// Reads the whole file in one block, returns false if it cannot be opened or read
+bool readSourceFile(const std::filesystem::path& file, SourceFile& source);
+
+#endif // SOURCE_FILE_H
@@ -1,10 +1,41 @@
 #ifndef STRING_H
 #define STRING_H
 
-#include <vector>
+#include <cstddef>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <compiler/outputBuffer.h>
+
+// String literals of one compile, numbered in the order they are first registered
+class StringTable
+{
+private:
+	struct CompilerString
+	{
+		const std::string signature;
+		// Escaped for the DW directive
+		const std::string value;
+	};
+
+	std::vector<CompilerString> m_strings;
+	// Index into m_strings for every raw literal
+	std::unordered_map<std::string, size_t> m_index;
+	// Function bodies are generated concurrently. They only look up strings the declaration pass registered
+	mutable std::mutex m_mutex;
+
+public:
+	// Index of the string, its label is .str<index>
+	size_t registerString(std::string_view str);
+	// Writes the data section entry of every registered string
+	void emitStrings(OutputBuffer& out) const;
 
-const std::string registerString(const std::string& str);
-const std::vector<std::string> getStrings();
+	size_t getCount() const;
+	// Bytes of the escaped values the data section holds
+	size_t getDataSize() const;
+};
 
 #endif // STRING_H
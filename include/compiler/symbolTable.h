@@ -0,0 +1,58 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <cstdint>
+#include <vector>
+#include <string_view>
+
+#include <compiler/token.h>
+
+typedef uint32_t SymbolId;
+
+constexpr SymbolId NO_SYMBOL = SymbolId(-1);
+
+// Every identifier gets a small integer id the first time it is seen,
+// symbol tables index their lookup arrays with it instead of hashing names
+SymbolId internSymbol(std::string_view name);
+// Id of an already interned name, NO_SYMBOL if it was never interned
+SymbolId findSymbol(std::string_view name);
+// Forgets every id, the next name interned gets 0 again. Only safe between compiles
+void clearSymbols();
+
+// Variables of a function, in stack order. Nested scopes push a marker
+// and pop back to it when they end, so bodies share the table instead of copying it
+class SymbolTable
+{
+public:
+	struct Symbol
+	{
+		SymbolId id;
+		size_t stackOffset;
+		Token type;
+	};
+
+private:
+	std::vector<Symbol> m_symbols;
+	// Index into m_symbols + 1 for every symbol id, 0 if the name is not declared
+	std::vector<uint32_t> m_lookup;
+	// m_symbols size when each open scope started
+	std::vector<size_t> m_scopes;
+	// Most variables the table ever held at once
+	size_t m_peak = 0;
+
+public:
+	void push(std::string_view name, const Token& type);
+
+	void pushScope();
+	// Removes the variables of the innermost scope and returns how many there were
+	const size_t popScope();
+
+	const Symbol* find(std::string_view name) const;
+
+	const size_t getOffset(std::string_view name) const;
+	const Token  getType  (std::string_view name) const;
+	const size_t getSize  ()                        const;
+	const size_t getPeakSize()                      const;
+};
+
+#endif // SYMBOL_TABLE_H
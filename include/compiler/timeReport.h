@@ -0,0 +1,99 @@
+#ifndef TIME_REPORT_H
+#define TIME_REPORT_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Wall and CPU time of every compile phase, for -ftime-report.
+// Phases nest, and each one only counts the time not spent in the phases
+// started inside it on the same thread, so the phases add up to the compile
+
+enum class Phase: uint8_t
+{
+	PH_READ,        // Reading the input
+	PH_CACHE,       // Looking the output up in the compile cache and storing it
+	PH_TOKENIZE,
+	PH_PARSE,       // Building the tree
+	PH_DECLARE,     // Declaration pass
+	PH_IMPORT,      // importLibrary, finding and listing the library
+	PH_URCL,        // parseURCLSource, reading and linking URCL library files
+	PH_HEXAGN,      // parseHexagnSource, reading Hexagn library files
+	PH_CODEGEN,     // Generating function bodies and the top level code
+	PH_LINKER,      // Adding and resolving functions
+	PH_EMIT,        // Writing functions, strings and the output file
+
+	PH_COUNT
+};
+
+class TimeReport
+{
+public:
+	struct Time
+	{
+		uint64_t wallNs = 0;
+		uint64_t cpuNs = 0;
+		size_t count = 0;
+	};
+
+private:
+	Time m_phases[size_t(Phase::PH_COUNT)];
+	// Including the phases inside them, in the order they finished
+	std::vector<std::pair<std::string, Time>> m_libraries;
+	std::vector<std::pair<std::string, Time>> m_functions;
+
+	const std::chrono::steady_clock::time_point m_start;
+	const uint64_t m_startCpuNs;
+
+	// Function bodies are generated concurrently
+	mutable std::mutex m_mutex;
+
+public:
+	TimeReport();
+
+	void add(const Phase& phase, const Time& time);
+	void addLibrary(const std::string& name, const Time& time);
+	void addFunction(const std::string& name, const Time& time);
+
+	// Table of the phases, the slowest function bodies and every library
+	void print(std::ostream& out) const;
+	void printJson(std::ostream& out) const;
+};
+
+// Phase the calling thread is in, PH_COUNT outside of every phase
+Phase getCurrentPhase();
+// Name used in the reports, "outside phases" for PH_COUNT
+const char* getPhaseName(const Phase& phase);
+
+// Puts the thread in a phase until it goes out of scope, and times the phase
+// if there is a report. With a name, the whole time is also listed under
+// that library or function
+class PhaseTimer
+{
+private:
+	TimeReport* m_report;
+	Phase m_phase;
+	Phase m_previousPhase;
+	const std::string* m_name = nullptr;
+
+	std::chrono::steady_clock::time_point m_startWall;
+	uint64_t m_startCpuNs = 0;
+
+	// Time of the phases started inside this one on the same thread
+	uint64_t m_childWallNs = 0;
+	uint64_t m_childCpuNs = 0;
+	PhaseTimer* m_parent = nullptr;
+
+public:
+	PhaseTimer(TimeReport* report, const Phase& phase, const std::string* name = nullptr);
+	~PhaseTimer();
+
+	PhaseTimer(const PhaseTimer&) = delete;
+	PhaseTimer& operator =(const PhaseTimer&) = delete;
+};
+
+#endif // TIME_REPORT_H
@@ -1,9 +1,11 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 
-enum class TokenType: size_t
+enum class TokenType: uint8_t
 {
 	// Builtin datatypes
 	TT_VOID,
@@ -56,20 +58,27 @@ enum class TokenType: size_t
 	TT_RETURN,
 };
 
-extern const std::string KEYWORDS[];
-
+// Tokens do not own their text, m_val views either the source buffer the
+// token was lexed from or text stored with internTokenText()
 struct Token
 {
-	size_t m_lineno;
 	TokenType m_type;
-	std::string m_val;
+	uint32_t m_lineno;
+
+	uint32_t m_start;
+	uint32_t m_end;
 
-	size_t m_start;
-	size_t m_end;
+	std::string_view m_val;
 
-	Token(size_t lineno, TokenType type, std::string val, size_t start, size_t end);
+	Token(size_t lineno, TokenType type, std::string_view val, size_t start, size_t end);
 
 	std::string toString() const;
 };
 
+// Stores text that has no backing source buffer (decoded literals, library
+// signatures, ...) for the rest of the compile and returns a view of it
+std::string_view internTokenText(std::string_view text);
+// Frees every stored text. Only safe between compiles, once no token or symbol id views one
+void clearTokenTexts();
+
 #endif // TOKEN_H
@@ -3,9 +3,10 @@
 
 #include <string>
 #include <compiler/linker.h>
+#include <compiler/compilerContext.h>
 
-void importLibrary(Linker& targetLinker, const std::string& libName);
+void importLibrary(CompilerContext& context, Linker& targetLinker, const std::string& libName);
 
-void addPath(const std::string& path);
+void addPath(CompilerContext& context, const std::string& path);
 
 #endif // IMPORT_HELPER_H
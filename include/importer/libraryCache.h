@@ -0,0 +1,52 @@
+#ifndef LIBRARY_CACHE_H
+#define LIBRARY_CACHE_H
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <compiler/linker.h>
+#include <compiler/token.h>
+
+struct Function;
+class MappedFile;
+
+// Parsed library files are cached in the user cache directory, so later
+// compiles add their functions to the linker without parsing them again.
+// Entries are keyed by the library path and only used while the file's
+// mtime, size and content hash still match
+
+void setLibraryCacheEnabled(const bool& enabled);
+
+// Records what a library file does to the linker while it is parsed, in order
+class LibraryRecorder
+{
+private:
+	std::string m_entries;
+
+public:
+	// A call the library resolved, it has to resolve to the same function when the entry is loaded
+	void addCall(const Token& name, const std::vector<Token>& argTypes, const Function& resolved);
+	void addFunction(const Function& function);
+
+	const std::string& getEntries() const;
+};
+
+// Cached entries of a library file whose header matched it, not applied to any linker yet
+struct LibraryCacheEntry
+{
+	// Empty if there was no usable cache file
+	std::shared_ptr<const MappedFile> mapping;
+	std::string_view entries;
+};
+
+// Does not touch any shared state, so it can run concurrently for many files
+LibraryCacheEntry openLibraryCache(const std::filesystem::path& file, std::string_view source);
+// Adds the cached functions of a library to the linker. Returns false, with
+// the linker left untouched, if the entry does not fit and the file has to be parsed
+bool applyLibraryCache(Linker& targetLinker, const LibraryCacheEntry& entry);
+void storeLibraryCache(const std::filesystem::path& file, std::string_view source, const LibraryRecorder& recorder);
+
+#endif // LIBRARY_CACHE_H
@@ -0,0 +1,33 @@
+#ifndef MEMORY_LIBRARY_H
+#define MEMORY_LIBRARY_H
+
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <compiler/sourceFile.h>
+
+// Library files held in memory instead of on disk, by their path below the
+// library root, like "io/print.urcl". A compile with one resolves its imports
+// against it alone, so it never touches the filesystem
+class MemoryLibrary
+{
+private:
+	// Sorted, so directories list in the same order a sorted directory listing would
+	std::map<std::filesystem::path, SourceFile> m_files;
+
+public:
+	// Replaces a file added before under the same path
+	void addFile(const std::filesystem::path& path, std::string source);
+	void clear();
+
+	// nullptr if there is no such file
+	const SourceFile* findFile(const std::filesystem::path& path) const;
+	// A file, or a directory some file is in
+	bool exists(const std::filesystem::path& path) const;
+	// Files directly inside dir, sorted
+	std::vector<std::filesystem::path> listDirectory(const std::filesystem::path& dir) const;
+};
+
+#endif // MEMORY_LIBRARY_H
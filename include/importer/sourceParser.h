@@ -2,10 +2,19 @@
 #define SOURCE_PARSER_H
 
 #include <filesystem>
+#include <vector>
 
 #include <compiler/linker.h>
+#include <compiler/compilerContext.h>
 
-void parseURCLSource(Linker& targetLinker, const std::filesystem::path& file);
-void parseHexagnSource(Linker& targetLinker, const std::filesystem::path& file);
+void parseURCLSource(CompilerContext& context, Linker& targetLinker, const std::filesystem::path& file);
+void parseHexagnSource(CompilerContext& context, Linker& targetLinker, const std::filesystem::path& file);
+// Loads library files into the linker in the given order. URCL files are read and parsed concurrently first
+void parseLibraryFiles(CompilerContext& context, Linker& targetLinker, const std::vector<std::filesystem::path>& files);
+// Reads and parses every URCL file below dir ahead of time and keeps them in memory,
+// for a compile server whose workers inherit them
+void preloadLibraryFiles(const std::filesystem::path& dir);
+// Drops the parsed files of in-memory libraries, and the source buffers they keep alive
+void clearMemorySources();
 
 #endif // SOURCE_PARSER_H
@@ -0,0 +1,49 @@
+#ifndef MEMORY_COMPILE_H
+#define MEMORY_COMPILE_H
+
+#include <string>
+#include <vector>
+
+#include <compiler/diagnostics.h>
+#include <importer/memoryLibrary.h>
+
+struct MemoryCompileResult
+{
+	bool succeeded;
+	// Empty if the compile failed
+	std::string urcl;
+	std::vector<Diagnostic> errors;
+};
+
+// Compiles source text with its imports resolved against library, nothing is
+// read from or written to disk apart from the compile caches
+MemoryCompileResult compileInMemory(const std::string& source, const MemoryLibrary& library, const bool& debugSymbols, const bool& emitEntryPoint);
+
+// Library files built into the program, ended by an entry with a null path
+struct EmbeddedLibraryFile
+{
+	const char* path;
+	const char* source;
+};
+
+#ifdef HEXAGN_STDLIB_SNAPSHOT
+// Generated from the stdlib by the wasm build
+extern const EmbeddedLibraryFile stdlibSnapshot[];
+#endif
+
+// Entry points of the WebAssembly build. The library starts out with the
+// stdlib snapshot if one is built in, and stays parsed between compiles.
+// The compile caches are off, so the filesystem is never touched
+extern "C"
+{
+	// Adds or replaces a library file, path is below the library root like "io/print.urcl"
+	void hexagnAddLibraryFile(const char* path, const char* source);
+	// Drops every library file and its parsed copy, the stdlib snapshot included
+	void hexagnClearLibraryFiles();
+	// Returns { "success": bool, "urcl": string, "errors": [ { "message", "line", "start", "end", "text" } ] }
+	// as JSON, valid until the next call. Errors that are not about a place in the source have a line of 0.
+	// The WebAssembly build frees the names interned while compiling before it returns
+	const char* hexagnCompile(const char* source, int debugSymbols, int emitEntryPoint);
+}
+
+#endif // MEMORY_COMPILE_H
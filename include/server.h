@@ -0,0 +1,22 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Compiles a full command line, args[0] being the program name, and writes its messages to log.
+// Returns the exit code
+typedef int (*CommandLineHandler)(const std::vector<std::string>& args, std::ostream& log);
+
+// Serves compile requests on a Unix domain socket until killed. The URCL files
+// below every preload directory are parsed once up front, then every request
+// runs in a forked worker that inherits them along with the rest of the
+// server's memory, so a failing compile only ends its own worker
+int runServer(const std::string& socketPath, const std::vector<std::string>& preloadDirs, CommandLineHandler handler);
+
+// Forwards a command line, the working directory and the standard streams to a
+// server. Returns the exit code of the compile
+int runClient(const std::string& socketPath, const std::vector<std::string>& args);
+
+#endif // SERVER_H
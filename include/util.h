@@ -1,21 +1,35 @@
 #ifndef UTIL_H
 #define UTIL_H
 
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <compiler/token.h>
+#include <compiler/sourceFile.h>
 
 int indexOf(char* arr[], std::string element, int size);
 std::string replace(std::string str, const std::string& from, const std::string& to);
 std::vector<std::string> split(std::string str, char sep);
-void drawArrows(size_t start, size_t end, const size_t& lineno);
-size_t find_nth(std::string haystack, const char& needle, const size_t& nth);
-const std::string getSourceLine(const std::string& src, const size_t& line);
+// Arrows under columns start to end of a line quoted as "lineno: line"
+std::string getArrows(size_t start, size_t end, const size_t& lineno);
+const std::string getSourceLine(const SourceFile& src, const size_t& line);
+// 64-bit FNV-1a, for cache keys
+uint64_t hashBytes(std::string_view data);
+// Threads working on a parallelFor call, the caller included. 0 uses one per hardware thread
+void setThreadCount(const size_t& count);
+// Runs body(i) for every i below count on the calling thread and a pool of worker threads
+// kept for the whole process, and returns once all of them are done. Calls may nest
+void parallelFor(const size_t& count, const std::function<void(size_t)>& body);
 
 const bool isIntegerDataType(const Token& tok);
 const bool isFloatDataType(const Token& tok);
 const bool isNumber(const Token& tok);
+const bool isOperator(const Token& tok);
+const bool isDataType(const Token& tok);
+const bool isComparison(const Token& tok);
 
 namespace std
 {
@@ -0,0 +1,273 @@
+#include <batch.h>
+
+#include <iostream>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+#include <util.h>
+#include <compiler/compilerContext.h>
+#include <importer/sourceParser.h>
+
+struct BatchResult
+{
+	bool succeeded;
+	// Everything the compile wrote to stdout and stderr
+	std::string log;
+};
+
+// Results of the inputs, printed in input order no matter which compile finishes first
+struct BatchReport
+{
+	const std::vector<std::string>& inputs;
+	std::vector<std::optional<BatchResult>> results;
+	size_t reported = 0;
+	size_t failed = 0;
+
+	// Prints the finished results that are next in input order
+	void print()
+	{
+		while (reported < inputs.size() && results[reported])
+		{
+			const BatchResult& result = *results[reported];
+			if (result.succeeded)
+				std::cout << "[ok]     " << inputs[reported] << '\n';
+			else
+			{
+				std::cout << "[failed] " << inputs[reported] << '\n';
+				failed++;
+			}
+			std::cout.flush();
+
+			std::cerr << result.log;
+			std::cerr.flush();
+
+			results[reported].reset();
+			reported++;
+		}
+	}
+};
+
+static std::string getOutputFile(const std::string& input, const std::string& outputDir)
+{
+	std::filesystem::path output = input;
+	output.replace_extension(".urcl");
+	if (!outputDir.empty())
+		output = std::filesystem::path(outputDir) / output.filename();
+
+	return output.string();
+}
+
+static std::vector<std::string> getCommandLine(const std::string& input, const std::string& output, const std::vector<std::string>& flags)
+{
+	std::vector<std::string> args { "hexagn", input, "-o", output };
+	args.insert(args.end(), flags.begin(), flags.end());
+	return args;
+}
+
+// Compiles the inputs on the threads of parallelFor, each with a context of its own
+static void compileOnThreads(BatchReport& report, const std::vector<std::string>& outputs, const std::vector<std::string>& flags, const size_t& workerCount, CommandLineHandler handler)
+{
+	// Bodies of an input are generated on whichever of the threads are idle
+	setThreadCount(workerCount);
+
+	std::mutex reportMutex;
+	parallelFor(report.inputs.size(), [&report, &outputs, &flags, &handler, &reportMutex](size_t input)
+	{
+		{
+			std::lock_guard<std::mutex> lock(reportMutex);
+			if (report.results[input])
+				return;
+		}
+
+		std::ostringstream log;
+		bool succeeded;
+		try
+		{
+			succeeded = handler(getCommandLine(report.inputs[input], outputs[input], flags), log) == 0;
+		}
+		catch (const std::exception& error)
+		{
+			log << "Error: " << error.what() << '\n';
+			succeeded = false;
+		}
+
+		std::lock_guard<std::mutex> lock(reportMutex);
+		report.results[input] = BatchResult { succeeded, log.str() };
+		report.print();
+	});
+}
+
+#if defined(_WIN32) || defined(__EMSCRIPTEN__)
+
+static bool compileInWorkers(BatchReport&, const std::vector<std::string>&, const std::vector<std::string>&, const size_t&, CommandLineHandler)
+{
+	std::cerr << "Error: --fork is not supported on this platform\n";
+	return false;
+}
+
+#else
+
+// A worker compiling one input, its output goes to an unlinked temporary file
+struct BatchWorker
+{
+	pid_t pid;
+	size_t input;
+	std::FILE* log;
+};
+
+static std::string readLog(std::FILE* log)
+{
+	std::string text;
+	std::rewind(log);
+
+	char buffer[4096];
+	size_t count;
+	while ((count = std::fread(buffer, 1, sizeof(buffer), log)) > 0)
+		text.append(buffer, count);
+
+	return text;
+}
+
+static std::optional<BatchWorker> startWorker(const size_t& input, const std::vector<std::string>& args, CommandLineHandler handler)
+{
+	std::FILE* log = std::tmpfile();
+	if (log == nullptr)
+		return std::nullopt;
+
+	// Nothing buffered may be written twice
+	std::cout.flush();
+	std::cerr.flush();
+	std::fflush(nullptr);
+
+	const pid_t pid = fork();
+	if (pid < 0)
+	{
+		std::fclose(log);
+		return std::nullopt;
+	}
+
+	if (pid == 0)
+	{
+		dup2(fileno(log), STDOUT_FILENO);
+		dup2(fileno(log), STDERR_FILENO);
+
+		// Inputs are compiled side by side instead
+		setThreadCount(1);
+
+		// exit flushes the streams the compile wrote to
+		exit(handler(args, std::cerr));
+	}
+
+	return BatchWorker { pid, input, log };
+}
+
+// Compiles every input in a forked worker, so even a crash only fails its own input
+static bool compileInWorkers(BatchReport& report, const std::vector<std::string>& outputs, const std::vector<std::string>& flags, const size_t& workerCount, CommandLineHandler handler)
+{
+	std::vector<BatchWorker> running;
+	size_t next = 0;
+
+	while (report.reported < report.inputs.size())
+	{
+		while (running.size() < workerCount && next < report.inputs.size())
+		{
+			const size_t input = next++;
+			if (report.results[input])
+				continue;
+
+			if (const std::optional<BatchWorker> worker = startWorker(input, getCommandLine(report.inputs[input], outputs[input], flags), handler))
+				running.push_back(*worker);
+			else
+				report.results[input] = BatchResult { false, "Error: Could not start a worker\n" };
+		}
+
+		if (!running.empty())
+		{
+			int status;
+			const pid_t pid = waitpid(-1, &status, 0);
+
+			for (size_t i = 0; i < running.size(); ++i)
+			{
+				if (running[i].pid != pid)
+					continue;
+
+				const bool succeeded = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+				report.results[running[i].input] = BatchResult { succeeded, readLog(running[i].log) };
+
+				std::fclose(running[i].log);
+				running.erase(running.begin() + i);
+				break;
+			}
+		}
+
+		report.print();
+	}
+
+	return true;
+}
+
+#endif
+
+int runBatch(const std::vector<std::string>& inputs, const std::string& outputDir, const size_t& jobs, const bool& forkWorkers, const std::vector<std::string>& flags, CommandLineHandler handler)
+{
+	const size_t workerCount = jobs != 0 ? jobs : std::max(1u, std::thread::hardware_concurrency());
+
+	if (!outputDir.empty())
+	{
+		std::error_code ec;
+		std::filesystem::create_directories(outputDir, ec);
+	}
+
+	// Parsed once here, every compile shares them
+	const CompilerContext defaults;
+	for (const std::filesystem::path& path: defaults.libPaths)
+		preloadLibraryFiles(path);
+	for (size_t i = 0; i + 1 < flags.size(); ++i)
+		if (flags[i] == "-L")
+			preloadLibraryFiles(flags[++i]);
+
+	BatchReport report { inputs, std::vector<std::optional<BatchResult>>(inputs.size()) };
+
+	// Inputs with the same file name in different directories would overwrite each
+	// other's output in outputDir, the later ones fail before any compile starts
+	std::vector<std::string> outputs(inputs.size());
+	std::map<std::filesystem::path, size_t> writers;
+	for (size_t i = 0; i < inputs.size(); ++i)
+	{
+		outputs[i] = getOutputFile(inputs[i], outputDir);
+
+		std::error_code ec;
+		const std::filesystem::path output = std::filesystem::absolute(outputs[i], ec).lexically_normal();
+		const auto [writer, inserted] = writers.try_emplace(output, i);
+		if (!inserted)
+			report.results[i] = BatchResult { false, "Error: Output file " + outputs[i] + " is also written for " + inputs[writer->second] + '\n' };
+	}
+
+	if (forkWorkers)
+	{
+		if (!compileInWorkers(report, outputs, flags, workerCount, handler))
+			return -1;
+	}
+	else
+		compileOnThreads(report, outputs, flags, workerCount, handler);
+
+	// Inputs that failed before any compile started, in case none came after them
+	report.print();
+
+	std::cout << inputs.size() - report.failed << " compiled, " << report.failed << " failed\n";
+	return report.failed == 0 ? 0 : -1;
+}
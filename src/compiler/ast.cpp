@@ -0,0 +1,500 @@
+#include <compiler/ast.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <util.h>
+#include <compiler/parser.h>
+
+class AstParser
+{
+private:
+	const SourceFile& m_src;
+	const std::vector<Token>& m_tokens;
+	Diagnostics& m_diagnostics;
+	Ast m_ast;
+
+	// Index of the '}' closing every '{', or the token count if it is never closed
+	std::vector<TokenIndex> m_closingBrace;
+
+	[[noreturn]] void syntaxError(const std::string& message, const Token& tok) const
+	{
+		m_diagnostics.error(m_src, message, tok);
+		throw CompileError();
+	}
+
+	struct Scope
+	{
+		// Node the statements belong to, NO_NODE for the top level
+		NodeIndex owner;
+		NodeIndex last;
+
+		// Index of the closing '}', the scope ends right before it
+		TokenIndex end;
+
+		// Functions can only be defined at the top level or in other function bodies
+		bool isSubScope;
+	};
+
+	std::vector<Scope> m_scopes;
+	TokenIndex m_pos = 0;
+
+	bool hasNext() const
+	{
+		return m_pos < m_scopes.back().end;
+	}
+
+	void advance()
+	{
+		m_pos++;
+	}
+
+	const Token& current() const
+	{
+		return m_tokens[m_pos < m_tokens.size() ? m_pos : m_tokens.size() - 1];
+	}
+
+	const Token& previous() const
+	{
+		return m_tokens[m_pos - 1];
+	}
+
+	NodeIndex newNode(NodeType type, TokenIndex token)
+	{
+		m_ast.nodes.push_back( { type, token, 0, 0, 0, 0, 0, NO_NODE, NO_NODE, NO_NODE } );
+		return NodeIndex(m_ast.nodes.size() - 1);
+	}
+
+	void matchBraces()
+	{
+		m_closingBrace.assign(m_tokens.size(), TokenIndex(m_tokens.size()));
+
+		std::vector<TokenIndex> open;
+		for (TokenIndex i = 0; i < m_tokens.size(); ++i)
+		{
+			if (m_tokens[i].m_type == TokenType::TT_OPEN_BRACE)
+				open.push_back(i);
+			else if (m_tokens[i].m_type == TokenType::TT_CLOSE_BRACE && !open.empty())
+			{
+				m_closingBrace[open.back()] = i;
+				open.pop_back();
+			}
+		}
+	}
+
+	// Collects expression tokens up to the ';' or the end of the scope
+	void parseExpression(NodeIndex node, const bool& allowStrings)
+	{
+		m_ast.nodes[node].begin = m_pos;
+		while (hasNext() && current().m_type != TokenType::TT_SEMICOLON)
+		{
+			const Token& curr = current();
+
+			if (!isNumber(curr) && !isOperator(curr) && curr.m_type != TokenType::TT_IDENTIFIER && curr.m_type != TokenType::TT_OPEN_PAREN && curr.m_type != TokenType::TT_CLOSE_PAREN && (!allowStrings || curr.m_type != TokenType::TT_STR))
+				syntaxError("Error: Expression cannot have non-number or non-operator or non-identifer or non-parenthesis tokens", curr);
+
+			advance();
+		}
+		m_ast.nodes[node].end = m_pos;
+
+		if (m_ast.nodes[node].begin == m_ast.nodes[node].end)
+			syntaxError("Error: Expected expression", previous());
+
+		// Past the ';'
+		advance();
+	}
+
+	// Parses "(lhs op rhs) {" of if and while statements
+	void parseCondition(NodeIndex node, const std::string& keyword)
+	{
+		const Token& keywordToken = current();
+
+		advance();
+		if (!hasNext() || current().m_type != TokenType::TT_OPEN_PAREN)
+			syntaxError("Error: Expected '(' after " + keyword, keywordToken);
+
+		advance();
+		if (!hasNext() || !(isNumber(current()) || current().m_type == TokenType::TT_IDENTIFIER))
+			syntaxError("Error: Expected number or identifier after (", previous());
+		m_ast.nodes[node].lhs = m_pos;
+
+		advance();
+		if (!hasNext() || !isComparison(current()))
+			syntaxError("Error: Expected comparison operator after identifier/number", previous());
+		m_ast.nodes[node].name = m_pos;
+
+		advance();
+		if (!hasNext() || !(isNumber(current()) || current().m_type == TokenType::TT_IDENTIFIER))
+			syntaxError("Error: Expected number or identifier after comparison", previous());
+		m_ast.nodes[node].rhs = m_pos;
+
+		advance();
+		if (!hasNext() || current().m_type != TokenType::TT_CLOSE_PAREN)
+			syntaxError("Error: Expected ')' after condition", previous());
+
+		advance();
+		if (!hasNext() || current().m_type != TokenType::TT_OPEN_BRACE)
+			syntaxError("Error: Expecter '{' after closing ')'", previous());
+	}
+
+	// The current token is the '{' opening the body of node
+	void openBody(NodeIndex node, const bool& isSubScope)
+	{
+		const TokenIndex end = m_closingBrace[m_pos];
+		advance();
+		m_scopes.push_back( { node, NO_NODE, end, isSubScope } );
+	}
+
+	void parseDefinition(Scope& scope)
+	{
+		const TokenIndex typeIndex = m_pos;
+		const Token& type = current();
+
+		advance();
+		if (!hasNext() || current().m_type != TokenType::TT_IDENTIFIER)
+			syntaxError("Error: Expected identifier after keyword", type);
+		const TokenIndex nameIndex = m_pos;
+
+		advance();
+		if (!hasNext() || (current().m_type != TokenType::TT_ASSIGN && current().m_type != TokenType::TT_OPEN_PAREN && current().m_type != TokenType::TT_SEMICOLON))
+			syntaxError("Error: Expected '=' or ';' or '('", previous());
+
+		// Variable definition
+		if (current().m_type == TokenType::TT_ASSIGN)
+		{
+			if (type.m_type == TokenType::TT_VOID)
+				syntaxError("Error: Cannot have void type for variable", type);
+
+			advance();
+			if (!hasNext())
+				syntaxError("Error: Expected expression after '='", previous());
+
+			const NodeIndex node = newNode(NodeType::NT_VAR_DEFINITION, typeIndex);
+			m_ast.nodes[node].name = nameIndex;
+			append(scope, node);
+
+			parseExpression(node, true);
+		}
+
+		// Variable declaration
+		else if (current().m_type == TokenType::TT_SEMICOLON)
+		{
+			const NodeIndex node = newNode(NodeType::NT_VAR_DECLARATION, typeIndex);
+			m_ast.nodes[node].name = nameIndex;
+			append(scope, node);
+
+			advance();
+		}
+
+		// Function definition
+		else
+		{
+			if (scope.isSubScope)
+				syntaxError("Error: Nested functions are not supported", type);
+
+			const NodeIndex node = newNode(NodeType::NT_FUNCTION, typeIndex);
+			m_ast.nodes[node].name = nameIndex;
+			append(scope, node);
+
+			advance();
+			if (!hasNext() || !(isDataType(current()) || current().m_type == TokenType::TT_CLOSE_PAREN))
+				syntaxError("Error: Expected keyword or ')'", previous());
+
+			// Parameters
+			NodeIndex lastParam = NO_NODE;
+			while (hasNext() && current().m_type != TokenType::TT_CLOSE_PAREN)
+			{
+				if (!isDataType(current()))
+					syntaxError("Error: Expected keyword or ')'", current());
+				const TokenIndex paramType = m_pos;
+
+				advance();
+				if (!hasNext() || current().m_type != TokenType::TT_IDENTIFIER)
+					syntaxError("Error: Expected identifier after keyword", previous());
+
+				const NodeIndex param = newNode(NodeType::NT_PARAMETER, paramType);
+				m_ast.nodes[param].name = m_pos;
+				if (lastParam == NO_NODE)
+					m_ast.nodes[node].list = param;
+				else
+					m_ast.nodes[lastParam].next = param;
+				lastParam = param;
+
+				advance();
+				if (!hasNext())
+					syntaxError("Error: Expected ',' or ')'", previous());
+
+				if (current().m_type == TokenType::TT_CLOSE_PAREN)
+					break;
+				else if (current().m_type != TokenType::TT_COMMA)
+					syntaxError("Error: Expected ',' or ')'", current());
+
+				advance();
+			}
+
+			advance();
+			if (!hasNext() || current().m_type != TokenType::TT_OPEN_BRACE)
+				syntaxError("Error: Expected '{'", previous());
+
+			if (m_pos + 1 >= scope.end)
+				syntaxError("Error: Expected function body or '}'", current());
+
+			m_ast.nodes[node].begin = typeIndex;
+			m_ast.nodes[node].end = std::min<TokenIndex>(m_closingBrace[m_pos] + 1, m_tokens.size());
+
+			openBody(node, false);
+		}
+	}
+
+	void parseIdentifier(Scope& scope)
+	{
+		const TokenIndex identIndex = m_pos;
+		const Token& identifier = current();
+
+		advance();
+		if (!hasNext() || (current().m_type != TokenType::TT_ASSIGN && current().m_type != TokenType::TT_OPEN_PAREN))
+			syntaxError("Error: Expected '=' or function call after identifier", identifier);
+
+		// Variable reassignment
+		if (current().m_type == TokenType::TT_ASSIGN)
+		{
+			advance();
+			if (!hasNext())
+				syntaxError("Error: Expected expression after '='", previous());
+
+			const NodeIndex node = newNode(NodeType::NT_ASSIGNMENT, identIndex);
+			append(scope, node);
+
+			parseExpression(node, false);
+		}
+
+		// Function call
+		else
+		{
+			advance();
+			if (!hasNext())
+				syntaxError("Error: Expected identifier or ')'", previous());
+
+			const NodeIndex node = newNode(NodeType::NT_CALL, identIndex);
+			append(scope, node);
+
+			NodeIndex lastArg = NO_NODE;
+			while (hasNext() && current().m_type != TokenType::TT_CLOSE_PAREN)
+			{
+				const Token& val = current();
+				if (val.m_type != TokenType::TT_IDENTIFIER && val.m_type != TokenType::TT_NUM && val.m_type != TokenType::TT_STR)
+					syntaxError("Error: Expected identifier or value", val);
+
+				const NodeIndex arg = newNode(NodeType::NT_ARGUMENT, m_pos);
+				if (lastArg == NO_NODE)
+					m_ast.nodes[node].list = arg;
+				else
+					m_ast.nodes[lastArg].next = arg;
+				lastArg = arg;
+
+				advance();
+
+				if (hasNext() && current().m_type == TokenType::TT_CLOSE_PAREN)
+					break;
+
+				if (!hasNext() || current().m_type != TokenType::TT_COMMA)
+					syntaxError("Error: Expected ',' or ')'", current());
+
+				advance();
+			}
+
+			// Past the ')'
+			advance();
+		}
+	}
+
+	void parseImport(Scope& scope)
+	{
+		const Token& import = current();
+		const NodeIndex node = newNode(NodeType::NT_IMPORT, m_pos);
+		append(scope, node);
+
+		advance();
+		m_ast.nodes[node].begin = m_pos;
+		while (hasNext() && current().m_type != TokenType::TT_SEMICOLON)
+		{
+			if (current().m_type != TokenType::TT_IDENTIFIER && current().m_type != TokenType::TT_URCL_BLOCK /* Since urcl literal becomes a urcl token */)
+				syntaxError("Error: Expected module name after import", current());
+
+			advance();
+			if (!hasNext())
+				syntaxError("Error: Expected '.' after module/submodule name", import);
+
+			if (current().m_type == TokenType::TT_SEMICOLON) break;
+			else if (current().m_type != TokenType::TT_DOT && current().m_type != TokenType::TT_COLON)
+				syntaxError("Error: Expected '.' or ':' or ';' after module/submodule name", current());
+
+			advance();
+		}
+		m_ast.nodes[node].end = m_pos;
+
+		// Past the ';'
+		advance();
+	}
+
+	void parseUrclBlock(Scope& scope)
+	{
+		const Token& urcl = current();
+		const NodeIndex node = newNode(NodeType::NT_URCL_BLOCK, m_pos);
+		append(scope, node);
+
+		advance();
+		if (!hasNext() || current().m_type != TokenType::TT_STR)
+			syntaxError("Error: Expected URCL Code in string after urcl", urcl);
+		m_ast.nodes[node].lhs = m_pos;
+
+		advance();
+		if (!hasNext() || current().m_type != TokenType::TT_SEMICOLON)
+			syntaxError("Error: Expected `;` after URCL code block", previous());
+
+		advance();
+	}
+
+	void parseStatement(Scope& scope)
+	{
+		const Token& curr = current();
+		switch (curr.m_type)
+		{
+			case TokenType::TT_VOID:
+			case TokenType::TT_INT:
+			case TokenType::TT_UINT:
+			case TokenType::TT_FLOAT:
+			case TokenType::TT_STRING:
+			case TokenType::TT_CHARACTER:
+				parseDefinition(scope);
+				break;
+
+			case TokenType::TT_IDENTIFIER:
+				parseIdentifier(scope);
+				break;
+
+			case TokenType::TT_IF:
+			case TokenType::TT_WHILE:
+			{
+				const bool isIf = curr.m_type == TokenType::TT_IF;
+				const NodeIndex node = newNode(isIf ? NodeType::NT_IF : NodeType::NT_WHILE, m_pos);
+				append(scope, node);
+
+				parseCondition(node, isIf ? "if" : "while");
+				openBody(node, true);
+				break;
+			}
+
+			case TokenType::TT_IMPORT:
+				parseImport(scope);
+				break;
+
+			case TokenType::TT_URCL_BLOCK:
+				parseUrclBlock(scope);
+				break;
+
+			case TokenType::TT_RETURN:
+			{
+				const NodeIndex node = newNode(NodeType::NT_RETURN, m_pos);
+				append(scope, node);
+
+				advance();
+				if (!hasNext())
+					syntaxError("Error: Expected expression after return", curr);
+
+				parseExpression(node, false);
+				break;
+			}
+
+			case TokenType::TT_SEMICOLON:
+				advance();
+				break;
+
+			default:
+				syntaxError("Unexpected token", curr);
+		}
+	}
+
+	// Skips the rest of a statement with a syntax error, up to and past its ';' or past the body it opens
+	void recover()
+	{
+		while (hasNext())
+		{
+			if (current().m_type == TokenType::TT_SEMICOLON)
+			{
+				advance();
+				return;
+			}
+
+			if (current().m_type == TokenType::TT_OPEN_BRACE)
+			{
+				m_pos = m_closingBrace[m_pos] + 1;
+				return;
+			}
+
+			advance();
+		}
+	}
+
+	void append(Scope& scope, NodeIndex node)
+	{
+		if (scope.last != NO_NODE)
+			m_ast.nodes[scope.last].next = node;
+		else if (scope.owner != NO_NODE)
+			m_ast.nodes[scope.owner].body = node;
+		else
+			m_ast.root = node;
+
+		scope.last = node;
+	}
+
+public:
+	AstParser(const SourceFile& src, const std::vector<Token>& tokens, Diagnostics& diagnostics)
+		: m_src(src), m_tokens(tokens), m_diagnostics(diagnostics), m_ast { tokens }
+	{}
+
+	Ast parse()
+	{
+		matchBraces();
+
+		// Bodies are parsed on an explicit scope stack rather than by recursion, so deep nesting cannot exhaust the stack
+		m_scopes.push_back( { NO_NODE, NO_NODE, TokenIndex(m_tokens.size()), false } );
+		while (true)
+		{
+			if (!hasNext())
+			{
+				// Past the closing '}'
+				m_pos = m_scopes.back().end + 1;
+				m_scopes.pop_back();
+
+				if (m_scopes.empty())
+					break;
+				continue;
+			}
+
+			// Copied since parsing a statement can open a new scope
+			Scope scope = m_scopes.back();
+			const size_t depth = m_scopes.size();
+
+			try
+			{
+				parseStatement(scope);
+			}
+			catch (const CompileError&)
+			{
+				recover();
+			}
+
+			m_scopes[depth - 1] = scope;
+		}
+
+		return std::move(m_ast);
+	}
+};
+
+Ast parseAst(const SourceFile& src, const std::vector<Token>& tokens, Diagnostics& diagnostics)
+{
+	return AstParser(src, tokens, diagnostics).parse();
+}
@@ -0,0 +1,186 @@
+#include <compiler/cacheFile.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <iterator>
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Set by every compile of a batch, which run on threads side by side
+static std::atomic<bool> cacheEnabled = true;
+
+void setCacheEnabled(const bool& enabled)
+{
+	cacheEnabled = enabled;
+}
+
+bool isCacheEnabled()
+{
+	return cacheEnabled;
+}
+
+const std::filesystem::path& getCacheDirectory()
+{
+	static const std::filesystem::path dir = []() -> std::filesystem::path
+	{
+		if (const char* path = std::getenv("HEXAGN_CACHE_DIR"))
+			return path;
+
+#ifdef _WIN32
+		if (const char* path = std::getenv("LOCALAPPDATA"))
+			return std::filesystem::path(path) / "hexagn" / "cache";
+#else
+		if (const char* path = std::getenv("XDG_CACHE_HOME"))
+			return std::filesystem::path(path) / "hexagn";
+		if (const char* path = std::getenv("HOME"))
+			return std::filesystem::path(path) / ".cache" / "hexagn";
+#endif
+
+		return {};
+	}();
+
+	return dir;
+}
+
+std::filesystem::path getCacheFile(const std::filesystem::path& dir, const uint64_t& key, const char* extension)
+{
+	if (dir.empty())
+		return {};
+
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx%s", (unsigned long long) key, extension);
+	return dir / name;
+}
+
+void writeCacheFile(const std::filesystem::path& file, std::string_view data)
+{
+	std::error_code ec;
+	std::filesystem::create_directories(file.parent_path(), ec);
+
+#ifdef _WIN32
+	const long long pid = _getpid();
+#else
+	const long long pid = getpid();
+#endif
+
+	// Batch and server workers are separate processes that often write the same
+	// key at once, so the process and thread go into the name along with the time
+	char suffix[80];
+	snprintf(suffix, sizeof(suffix), ".tmp%lld-%zx-%llx", pid,
+		std::hash<std::thread::id>()(std::this_thread::get_id()),
+		(unsigned long long) std::chrono::steady_clock::now().time_since_epoch().count());
+
+	std::filesystem::path tempFile = file;
+	tempFile += suffix;
+
+	{
+		std::ofstream out(tempFile, std::ios::binary);
+		if (!out.write(data.data(), data.size()))
+		{
+			out.close();
+			std::filesystem::remove(tempFile, ec);
+			return;
+		}
+	}
+
+	std::filesystem::rename(tempFile, file, ec);
+	if (ec)
+		std::filesystem::remove(tempFile, ec);
+}
+
+MappedFile::MappedFile(const std::filesystem::path& file)
+{
+#ifdef _WIN32
+	std::ifstream stream(file, std::ios::binary);
+	m_buffer.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+	m_data = m_buffer;
+#else
+	const int fd = open(file.c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+
+	struct stat info;
+	if (fstat(fd, &info) == 0 && info.st_size > 0)
+	{
+		void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED)
+			m_data = std::string_view(static_cast<const char*>(data), info.st_size);
+	}
+	close(fd);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifndef _WIN32
+	if (!m_data.empty())
+		munmap(const_cast<char*>(m_data.data()), m_data.size());
+#endif
+}
+
+void writeString(std::string& out, std::string_view str)
+{
+	writeValue(out, uint32_t(str.size()));
+	out.append(str);
+}
+
+void writeToken(std::string& out, const Token& tok)
+{
+	writeValue(out, uint8_t(tok.m_type));
+	writeString(out, tok.m_val);
+}
+
+void writeTokens(std::string& out, const std::vector<Token>& toks)
+{
+	writeValue(out, uint32_t(toks.size()));
+	for (const Token& tok: toks)
+		writeToken(out, tok);
+}
+
+std::string_view CacheReader::readString()
+{
+	const uint32_t size = read<uint32_t>();
+	if (m_data.size() < size)
+	{
+		m_valid = false;
+		m_data = {};
+		return {};
+	}
+
+	const std::string_view str = m_data.substr(0, size);
+	m_data.remove_prefix(size);
+	return str;
+}
+
+Token CacheReader::readToken()
+{
+	const TokenType type = TokenType(read<uint8_t>());
+	return Token(size_t(-1), type, readString(), size_t(-1), size_t(-1));
+}
+
+std::vector<Token> CacheReader::readTokens()
+{
+	std::vector<Token> toks;
+	const uint32_t count = read<uint32_t>();
+	for (uint32_t i = 0; i < count && m_valid; ++i)
+		toks.push_back(readToken());
+	return toks;
+}
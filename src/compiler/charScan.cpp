@@ -0,0 +1,258 @@
+#include <compiler/charScan.h>
+
+#include <string_view>
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+	#define HEXAGN_SCAN_X86
+	#include <immintrin.h>
+#endif
+
+//--------------------------------//
+//		  SCALAR
+//--------------------------------//
+static inline bool isBlank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline bool isWordChar(char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
+}
+
+static inline bool isDigitChar(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+static inline bool isStringChar(char c)
+{
+	return c != '"' && c != '\\' && c != '\n';
+}
+
+template <bool (*inRun)(char)>
+static size_t scanScalar(const char* data, size_t pos, size_t size)
+{
+	while (pos < size && inRun(data[pos]))
+		++pos;
+	return pos;
+}
+
+#ifdef HEXAGN_SCAN_X86
+//--------------------------------//
+//		  SSE2
+//--------------------------------//
+// Masks have 0xff in every byte that belongs to the run
+
+static inline __m128i rangeMask128(__m128i c, char lo, char hi)
+{
+	return _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8(lo - 1)), _mm_cmpgt_epi8(_mm_set1_epi8(hi + 1), c));
+}
+
+static inline __m128i blankMask128(__m128i c)
+{
+	return _mm_or_si128(
+		_mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(c, _mm_set1_epi8('\t'))),
+		_mm_cmpeq_epi8(c, _mm_set1_epi8('\r'))
+	);
+}
+
+static inline __m128i wordMask128(__m128i c)
+{
+	// Setting bit 5 folds upper case letters onto lower case ones
+	const __m128i letters = rangeMask128(_mm_or_si128(c, _mm_set1_epi8(0x20)), 'a', 'z');
+	const __m128i digits  = rangeMask128(c, '0', '9');
+	const __m128i extra   = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('_')), _mm_cmpeq_epi8(c, _mm_set1_epi8('-')));
+	return _mm_or_si128(_mm_or_si128(letters, digits), extra);
+}
+
+static inline __m128i digitMask128(__m128i c)
+{
+	return rangeMask128(c, '0', '9');
+}
+
+static inline __m128i stringMask128(__m128i c)
+{
+	const __m128i stop = _mm_or_si128(
+		_mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('"')), _mm_cmpeq_epi8(c, _mm_set1_epi8('\\'))),
+		_mm_cmpeq_epi8(c, _mm_set1_epi8('\n'))
+	);
+	return _mm_andnot_si128(stop, _mm_set1_epi8(-1));
+}
+
+template <__m128i (*runMask)(__m128i), bool (*inRun)(char)>
+static size_t scanSSE2(const char* data, size_t pos, size_t size)
+{
+	while (pos + 16 <= size)
+	{
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+		const unsigned outside = ~unsigned(_mm_movemask_epi8(runMask(chunk))) & 0xffffu;
+		if (outside != 0)
+			return pos + __builtin_ctz(outside);
+		pos += 16;
+	}
+
+	return scanScalar<inRun>(data, pos, size);
+}
+
+//--------------------------------//
+//		  AVX2
+//--------------------------------//
+#define HEXAGN_AVX2 __attribute__((target("avx2")))
+
+HEXAGN_AVX2 static inline __m256i rangeMask256(__m256i c, char lo, char hi)
+{
+	return _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8(lo - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), c));
+}
+
+HEXAGN_AVX2 static inline __m256i blankMask256(__m256i c)
+{
+	return _mm256_or_si256(
+		_mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\t'))),
+		_mm256_cmpeq_epi8(c, _mm256_set1_epi8('\r'))
+	);
+}
+
+HEXAGN_AVX2 static inline __m256i wordMask256(__m256i c)
+{
+	const __m256i letters = rangeMask256(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), 'a', 'z');
+	const __m256i digits  = rangeMask256(c, '0', '9');
+	const __m256i extra   = _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('_')), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('-')));
+	return _mm256_or_si256(_mm256_or_si256(letters, digits), extra);
+}
+
+HEXAGN_AVX2 static inline __m256i digitMask256(__m256i c)
+{
+	return rangeMask256(c, '0', '9');
+}
+
+HEXAGN_AVX2 static inline __m256i stringMask256(__m256i c)
+{
+	const __m256i stop = _mm256_or_si256(
+		_mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\\'))),
+		_mm256_cmpeq_epi8(c, _mm256_set1_epi8('\n'))
+	);
+	return _mm256_andnot_si256(stop, _mm256_set1_epi8(-1));
+}
+
+template <__m256i (*runMask)(__m256i), bool (*inRun)(char)>
+HEXAGN_AVX2 static size_t scanAVX2(const char* data, size_t pos, size_t size)
+{
+	while (pos + 32 <= size)
+	{
+		const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+		const unsigned outside = ~unsigned(_mm256_movemask_epi8(runMask(chunk)));
+		if (outside != 0)
+			return pos + __builtin_ctz(outside);
+		pos += 32;
+	}
+
+	return scanScalar<inRun>(data, pos, size);
+}
+#endif // HEXAGN_SCAN_X86
+
+//--------------------------------//
+//		  DISPATCH
+//--------------------------------//
+typedef size_t (*ScanFunction)(const char* data, size_t pos, size_t size);
+
+struct Scanners
+{
+	ScanFunction blanks;
+	ScanFunction word;
+	ScanFunction digits;
+	ScanFunction stringBody;
+};
+
+static const Scanners scalarScanners =
+{
+	scanScalar<isBlank>,
+	scanScalar<isWordChar>,
+	scanScalar<isDigitChar>,
+	scanScalar<isStringChar>
+};
+
+#ifdef HEXAGN_SCAN_X86
+static const Scanners sse2Scanners =
+{
+	scanSSE2<blankMask128,  isBlank>,
+	scanSSE2<wordMask128,   isWordChar>,
+	scanSSE2<digitMask128,  isDigitChar>,
+	scanSSE2<stringMask128, isStringChar>
+};
+
+static const Scanners avx2Scanners =
+{
+	scanAVX2<blankMask256,  isBlank>,
+	scanAVX2<wordMask256,   isWordChar>,
+	scanAVX2<digitMask256,  isDigitChar>,
+	scanAVX2<stringMask256, isStringChar>
+};
+#endif
+
+static ScanLevel detectScanLevel()
+{
+#ifdef HEXAGN_SCAN_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return ScanLevel::AVX2;
+	return ScanLevel::SSE2;
+#else
+	return ScanLevel::SCALAR;
+#endif
+}
+
+static const Scanners* getScanners(ScanLevel level)
+{
+	switch (level)
+	{
+#ifdef HEXAGN_SCAN_X86
+		case ScanLevel::AVX2: return &avx2Scanners;
+		case ScanLevel::SSE2: return &sse2Scanners;
+#endif
+		default:              return &scalarScanners;
+	}
+}
+
+static const ScanLevel bestLevel = detectScanLevel();
+static ScanLevel currentLevel = bestLevel;
+static const Scanners* scanners = getScanners(bestLevel);
+
+size_t scanBlanks(std::string_view data, size_t pos)
+{
+	return scanners->blanks(data.data(), pos, data.size());
+}
+
+size_t scanWord(std::string_view data, size_t pos)
+{
+	return scanners->word(data.data(), pos, data.size());
+}
+
+size_t scanDigits(std::string_view data, size_t pos)
+{
+	return scanners->digits(data.data(), pos, data.size());
+}
+
+size_t scanStringBody(std::string_view data, size_t pos)
+{
+	return scanners->stringBody(data.data(), pos, data.size());
+}
+
+ScanLevel getScanLevel()
+{
+	return currentLevel;
+}
+
+ScanLevel getBestScanLevel()
+{
+	return bestLevel;
+}
+
+void setScanLevel(ScanLevel level)
+{
+	if (level > bestLevel)
+		level = bestLevel;
+
+	currentLevel = level;
+	scanners = getScanners(level);
+}
@@ -0,0 +1,195 @@
+#include <compiler/compileCache.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <util.h>
+#include <compiler/cacheFile.h>
+
+// Bumped whenever the layout below or the code the compiler generates changes
+constexpr uint32_t CACHE_VERSION = 3;
+constexpr char CACHE_MAGIC[4] = { 'H', 'X', 'O', 'C' };
+
+// Dependency kinds
+constexpr uint8_t DEPENDENCY_FILE      = 'F';
+constexpr uint8_t DEPENDENCY_DIRECTORY = 'D';
+constexpr uint8_t DEPENDENCY_MISSING   = 'M';
+
+void CompileDependencies::record(const uint8_t& kind, const std::filesystem::path& path, const uint64_t& hash)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_hashes[ { kind, path.string() } ] = hash;
+}
+
+static uint64_t hashListing(const std::vector<std::filesystem::path>& files)
+{
+	std::string listing;
+	for (const std::filesystem::path& file: files)
+	{
+		listing += file.filename().string();
+		listing += '\0';
+	}
+
+	return hashBytes(listing);
+}
+
+void CompileDependencies::recordFile(const std::filesystem::path& file, std::string_view contents)
+{
+	record(DEPENDENCY_FILE, file, hashBytes(contents));
+}
+
+void CompileDependencies::recordDirectory(const std::filesystem::path& dir, const std::vector<std::filesystem::path>& files)
+{
+	record(DEPENDENCY_DIRECTORY, dir, hashListing(files));
+}
+
+void CompileDependencies::recordMissing(const std::filesystem::path& path)
+{
+	record(DEPENDENCY_MISSING, path, 0);
+}
+
+void CompileDependencies::write(std::string& out) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	writeValue(out, uint32_t(m_hashes.size()));
+	for (const auto& [dependency, hash]: m_hashes)
+	{
+		writeValue(out, dependency.first);
+		writeString(out, dependency.second);
+		writeValue(out, hash);
+	}
+}
+
+// Whether a dependency still looks the way it did when the entry was stored
+static bool isUnchanged(const uint8_t& kind, const std::filesystem::path& path, const uint64_t& hash)
+{
+	std::error_code ec;
+
+	switch (kind)
+	{
+		case DEPENDENCY_FILE:
+		{
+			if (!std::filesystem::is_regular_file(path, ec))
+				return false;
+
+			const MappedFile mapped(path);
+			return hashBytes(mapped.data()) == hash;
+		}
+
+		case DEPENDENCY_DIRECTORY:
+		{
+			// Listed the way importLibrary lists a library directory
+			std::vector<std::filesystem::path> files;
+			for (const auto& entry: std::filesystem::directory_iterator(path, ec))
+				if (!entry.is_directory())
+					files.push_back(entry.path());
+
+			if (ec)
+				return false;
+
+			std::sort(files.begin(), files.end());
+			return hashListing(files) == hash;
+		}
+
+		case DEPENDENCY_MISSING:
+			return !std::filesystem::exists(path, ec);
+
+		default:
+			return false;
+	}
+}
+
+static void writeHeader(std::string& out, const uint64_t& key)
+{
+	out.append(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	writeValue(out, CACHE_VERSION);
+	writeValue(out, key);
+}
+
+uint64_t getCompileKey(const std::vector<std::filesystem::path>& libPaths, std::string_view source, const bool& debugSymbols, const bool& emitEntryPoint)
+{
+	std::string key;
+	writeValue(key, CACHE_VERSION);
+	writeValue(key, uint8_t(debugSymbols));
+	writeValue(key, uint8_t(emitEntryPoint));
+
+	// Search paths decide which library an import finds
+	writeValue(key, uint32_t(libPaths.size()));
+	for (const std::filesystem::path& path: libPaths)
+		writeString(key, path.string());
+
+	key += source;
+	return hashBytes(key);
+}
+
+static std::filesystem::path getCompileCacheFile(const uint64_t& key)
+{
+	const std::filesystem::path& dir = getCacheDirectory();
+	if (dir.empty())
+		return {};
+
+	return getCacheFile(dir / "outputs", key, ".hxoc");
+}
+
+bool loadCompileCache(const uint64_t& key, OutputBuffer& code)
+{
+	if (!isCacheEnabled())
+		return false;
+
+	const std::filesystem::path cacheFile = getCompileCacheFile(key);
+	if (cacheFile.empty())
+		return false;
+
+	const MappedFile mapped(cacheFile);
+
+	std::string header;
+	writeHeader(header, key);
+	if (mapped.data().substr(0, header.size()) != header)
+		return false;
+
+	CacheReader reader(mapped.data().substr(header.size()));
+	const uint32_t count = reader.read<uint32_t>();
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const uint8_t kind = reader.read<uint8_t>();
+		const std::string_view path = reader.readString();
+		const uint64_t hash = reader.read<uint64_t>();
+
+		if (!reader.isValid() || !isUnchanged(kind, path, hash))
+			return false;
+	}
+
+	// The output comes after the dependencies
+	const std::string_view output = reader.readString();
+	if (!reader.isValid() || !reader.atEnd())
+		return false;
+
+	code << output;
+	return true;
+}
+
+void storeCompileCache(const uint64_t& key, const CompileDependencies& dependencies, const OutputBuffer& code)
+{
+	if (!isCacheEnabled())
+		return;
+
+	const std::filesystem::path cacheFile = getCompileCacheFile(key);
+	if (cacheFile.empty())
+		return;
+
+	std::string data;
+	writeHeader(data, key);
+	dependencies.write(data);
+	writeString(data, code.toString());
+
+	writeCacheFile(cacheFile, data);
+}
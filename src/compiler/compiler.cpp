@@ -1,55 +1,100 @@
 #include <compiler/compiler.h>
 
 #include <iostream>
+#include <iterator>
 #include <string>
 #include <sstream>
 #include <vector>
-#include <fstream>
+#include <cstdio>
+#include <cstdint>
 
 #include <util.h>
 #include <compiler/lexer.h>
 #include <compiler/parser.h>
 #include <compiler/linker.h>
+#include <compiler/outputBuffer.h>
+#include <compiler/compileCache.h>
+#include <compiler/timeReport.h>
 
-void compiler(const std::string& inputFileName, const std::string& outputFileName, const bool& debugSymbols, const bool& emitEntryPoint)
+bool compileSource(CompilerContext& context, OutputBuffer& code, const bool& debugSymbols, const bool& emitEntryPoint)
 {
-	// Storing entire source
-	std::string src;
+	// An unchanged program with unchanged libraries is not lexed at all.
+	// In-memory libraries have nothing on disk the cache could check them against
+	const bool useCache = context.memoryLibrary == nullptr;
+	uint64_t cacheKey = 0;
+	if (useCache)
+	{
+		PhaseTimer timer(context.timeReport, Phase::PH_CACHE);
+		cacheKey = getCompileKey(context.libPaths, context.src.getSource(), debugSymbols, emitEntryPoint);
+		if (loadCompileCache(cacheKey, code))
+			return true;
+	}
 
-	// File stream to read input file
-	std::ifstream inputFileStream(inputFileName);
+	Linker hexagnMainLinker(context);
 
-	if (!inputFileStream.is_open())
+	std::vector<Token> toks;
 	{
-		std::cout << "Error: Could not open input file: " << inputFileName << '\n';
-		exit(-1);
+		PhaseTimer timer(context.timeReport, Phase::PH_TOKENIZE);
+		toks = tokenize(context.src, context.diagnostics);
 	}
+	if (context.memReport != nullptr)
+		context.memReport->addTokens(toks);
+	// for (const auto& tok: toks)
+	// 	std::cout << tok.toString() + '\n';
+
+	// Tokens after a lexer error are not worth parsing, the errors would only repeat it
+	if (!context.diagnostics.hasErrors())
+		compile(context, code, hexagnMainLinker, toks, debugSymbols, true, emitEntryPoint);
+
+	if (context.diagnostics.hasErrors())
+		return false;
 
-	// Get all non-comment tokens into src
-	std::string str;
-	while(std::getline(inputFileStream, str))
+	if (useCache)
 	{
-		auto _toks = split(str, ' ');
-		
-		for (auto tok: _toks)
-		{
-			tok = replace(tok, "\t", "");
+		PhaseTimer timer(context.timeReport, Phase::PH_CACHE);
+		storeCompileCache(cacheKey, context.dependencies, code);
+	}
 
-			if (tok.starts_with("//"))
-				break;
+	return true;
+}
 
-			src += tok + ' ';
+bool compiler(CompilerContext& context, const std::string& inputFileName, const std::string& outputFileName, const bool& debugSymbols, const bool& emitEntryPoint)
+{
+	{
+		PhaseTimer timer(context.timeReport, Phase::PH_READ);
+
+		// "-" reads the source from stdin, which is how a compile server client passes inline source
+		if (inputFileName == "-")
+			context.src = SourceFile(std::string(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>()));
+		else if (!readSourceFile(inputFileName, context.src))
+		{
+			context.diagnostics.error("Error: Could not read input file: " + inputFileName + '\n');
+			return false;
 		}
+	}
+
+	// Nothing is written for a program with errors
+	OutputBuffer code;
+	if (!compileSource(context, code, debugSymbols, emitEntryPoint))
+		return false;
+
+	PhaseTimer emitTimer(context.timeReport, Phase::PH_EMIT);
 
-		src += '\n';
+	// "-" pipes the output to stdout
+	const bool toStdout = outputFileName == "-";
+	std::FILE* outputFile = toStdout ? stdout : std::fopen(outputFileName.c_str(), "wb");
+	if (outputFile == nullptr)
+	{
+		context.diagnostics.error("Error: Could not open output file: " + outputFileName + '\n');
+		return false;
 	}
 
-	Linker hexagnMainLinker;
+	const bool written = code.writeTo(outputFile);
+	if (!(toStdout ? std::fflush(outputFile) == 0 : std::fclose(outputFile) == 0) || !written)
+	{
+		context.diagnostics.error("Error: Could not write output file: " + outputFileName + '\n');
+		return false;
+	}
 
-	// We dont need the input file stream anymore, so close it
-	inputFileStream.close();
-	const auto& toks = tokenize(src);
-	// for (const auto& tok: toks)
-	// 	std::cout << tok.toString() + '\n';
-	std::ofstream(outputFileName) << compile(hexagnMainLinker, toks, debugSymbols, true, emitEntryPoint);
+	return true;
 }
@@ -0,0 +1,14 @@
+#include <compiler/compilerContext.h>
+
+CompilerContext::CompilerContext()
+	: libPaths {
+#ifdef _WIN32
+		"C:\\Program Files (x86)\\hexagn\\hexagn-stdlib",
+#else
+		"/usr/lib/hexagn/hexagn-stdlib/",
+#endif
+
+		// For dev
+		"./hexagn-stdlib/"
+	}
+{}
@@ -0,0 +1,65 @@
+#include <compiler/diagnostics.h>
+
+#include <string>
+#include <vector>
+#include <mutex>
+
+#include <util.h>
+
+void Diagnostics::error(const std::string& text)
+{
+	std::string message = text;
+	while (!message.empty() && message.back() == '\n')
+		message.pop_back();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_errors.push_back( { text, message } );
+}
+
+void Diagnostics::error(const SourceFile& src, const std::string& message, const size_t& lineno, const size_t& start, const size_t& end)
+{
+	std::string text = message + " at line " + std::to_string(lineno) + '\n';
+	text += std::to_string(lineno) + ": " + getSourceLine(src, lineno);
+	text += getArrows(start, end, lineno);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_errors.push_back( { text, message, lineno, start, end } );
+}
+
+void Diagnostics::error(const SourceFile& src, const std::string& message, const Token& tok)
+{
+	error(src, message, tok.m_lineno, tok.m_start, tok.m_end);
+}
+
+void Diagnostics::append(const Diagnostics& other)
+{
+	if (&other == this)
+		return;
+
+	std::scoped_lock lock(m_mutex, other.m_mutex);
+	m_errors.insert(m_errors.end(), other.m_errors.begin(), other.m_errors.end());
+}
+
+std::vector<Diagnostic> Diagnostics::getErrors() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_errors;
+}
+
+size_t Diagnostics::getErrorCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_errors.size();
+}
+
+bool Diagnostics::hasErrors() const
+{
+	return getErrorCount() != 0;
+}
+
+void Diagnostics::print(std::ostream& out) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const Diagnostic& diagnostic: m_errors)
+		out << diagnostic.text;
+}
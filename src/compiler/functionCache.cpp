@@ -0,0 +1,132 @@
+#include <compiler/functionCache.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <compiler/cacheFile.h>
+
+// Bumped whenever the layout below or the code bodies generate changes
+constexpr uint32_t CACHE_VERSION = 2;
+constexpr char CACHE_MAGIC[4] = { 'H', 'X', 'F', 'C' };
+
+static std::filesystem::path getFunctionCacheFile(const uint64_t& key)
+{
+	const std::filesystem::path& dir = getCacheDirectory();
+	if (dir.empty())
+		return {};
+
+	return getCacheFile(dir / "functions", key, ".hxfc");
+}
+
+static void writeHeader(std::string& out, const uint64_t& key)
+{
+	out.append(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	writeValue(out, CACHE_VERSION);
+	writeValue(out, key);
+}
+
+bool loadFunctionCache(const uint64_t& key, CachedFunction& function)
+{
+	if (!isCacheEnabled())
+		return false;
+
+	const std::filesystem::path cacheFile = getFunctionCacheFile(key);
+	if (cacheFile.empty())
+		return false;
+
+	const MappedFile mapped(cacheFile);
+
+	std::string header;
+	writeHeader(header, key);
+	if (mapped.data().substr(0, header.size()) != header)
+		return false;
+
+	CacheReader reader(mapped.data().substr(header.size()));
+	function.code = reader.readString();
+
+	const uint32_t relocationCount = reader.read<uint32_t>();
+	for (uint32_t i = 0; i < relocationCount && reader.isValid(); ++i)
+	{
+		Relocation relocation;
+		relocation.offset = reader.read<uint64_t>();
+		relocation.type = RelocationType(reader.read<uint8_t>());
+		relocation.number = reader.read<uint64_t>();
+		function.relocations.push_back(relocation);
+	}
+
+	const uint32_t stringCount = reader.read<uint32_t>();
+	for (uint32_t i = 0; i < stringCount && reader.isValid(); ++i)
+		function.strings.emplace_back(reader.readString());
+
+	const uint32_t callCount = reader.read<uint32_t>();
+	for (uint32_t i = 0; i < callCount && reader.isValid(); ++i)
+	{
+		CachedCall call;
+		call.name = reader.readString();
+
+		const uint32_t argCount = reader.read<uint32_t>();
+		for (uint32_t j = 0; j < argCount && reader.isValid(); ++j)
+			call.argTypes.push_back(TokenType(reader.read<uint8_t>()));
+
+		call.signature = reader.readString();
+		function.calls.push_back(std::move(call));
+	}
+
+	if (!reader.isValid() || !reader.atEnd())
+		return false;
+
+	// Relocations have to point into the code in order, so splicing never reads past it
+	size_t offset = 0;
+	for (const Relocation& relocation: function.relocations)
+	{
+		if (relocation.offset < offset || relocation.offset > function.code.size())
+			return false;
+		if (relocation.type == RelocationType::RT_STRING_LABEL && relocation.number >= function.strings.size())
+			return false;
+
+		offset = relocation.offset;
+	}
+
+	return true;
+}
+
+void storeFunctionCache(const uint64_t& key, const CachedFunction& function)
+{
+	if (!isCacheEnabled())
+		return;
+
+	const std::filesystem::path cacheFile = getFunctionCacheFile(key);
+	if (cacheFile.empty())
+		return;
+
+	std::string data;
+	writeHeader(data, key);
+	writeString(data, function.code);
+
+	writeValue(data, uint32_t(function.relocations.size()));
+	for (const Relocation& relocation: function.relocations)
+	{
+		writeValue(data, uint64_t(relocation.offset));
+		writeValue(data, uint8_t(relocation.type));
+		writeValue(data, uint64_t(relocation.number));
+	}
+
+	writeValue(data, uint32_t(function.strings.size()));
+	for (const std::string& str: function.strings)
+		writeString(data, str);
+
+	writeValue(data, uint32_t(function.calls.size()));
+	for (const CachedCall& call: function.calls)
+	{
+		writeString(data, call.name);
+		writeValue(data, uint32_t(call.argTypes.size()));
+		for (const TokenType& type: call.argTypes)
+			writeValue(data, uint8_t(type));
+		writeString(data, call.signature);
+	}
+
+	writeCacheFile(cacheFile, data);
+}
@@ -0,0 +1,256 @@
+#include <compiler/ir.h>
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <compiler/keywords.h>
+
+IrOperand irReg(const size_t& reg)
+{
+	return { IrOperandKind::IO_REG, IrLabelKind::IL_IF, reg };
+}
+
+IrOperand irImm(std::string_view imm)
+{
+	return { IrOperandKind::IO_IMM, IrLabelKind::IL_IF, 0, imm };
+}
+
+IrOperand irFloat(std::string_view imm)
+{
+	return { IrOperandKind::IO_FLOAT, IrLabelKind::IL_IF, 0, imm };
+}
+
+IrOperand irLocal(const size_t& offset)
+{
+	return { IrOperandKind::IO_LOCAL, IrLabelKind::IL_IF, offset };
+}
+
+IrOperand irArg(const size_t& offset)
+{
+	return { IrOperandKind::IO_ARG, IrLabelKind::IL_IF, offset };
+}
+
+IrOperand irCount(const size_t& count)
+{
+	return { IrOperandKind::IO_COUNT, IrLabelKind::IL_IF, count };
+}
+
+IrOperand irLabel(const IrLabelKind& kind, const size_t& number)
+{
+	return { IrOperandKind::IO_LABEL, kind, number };
+}
+
+IrOperand irString(const size_t& number, std::string_view string)
+{
+	return { IrOperandKind::IO_LABEL, IrLabelKind::IL_STRING, number, string };
+}
+
+IrOperand irFunction(std::string_view signature)
+{
+	return { IrOperandKind::IO_LABEL, IrLabelKind::IL_FUNCTION, 0, signature };
+}
+
+IrOperand irText(std::string_view text)
+{
+	return irImm(text);
+}
+
+IrType getIrType(const Token& dataType)
+{
+	const Keyword* keyword = findKeyword(dataType.m_val);
+	return { dataType.m_type, keyword != nullptr ? keyword->width : uint8_t(0) };
+}
+
+static bool endsBlock(const IrOp& op)
+{
+	return op == IrOp::IR_JMP || op == IrOp::IR_BRANCH || op == IrOp::IR_RET;
+}
+
+void IrBody::append(const IrInstruction& instruction)
+{
+	if (blocks.empty() || (!blocks.back().instructions.empty() && endsBlock(blocks.back().instructions.back().op)))
+		blocks.emplace_back();
+
+	blocks.back().instructions.push_back(instruction);
+}
+
+void IrBody::append(const std::vector<IrInstruction>& instructions)
+{
+	for (const IrInstruction& instruction: instructions)
+		append(instruction);
+}
+
+void IrBody::addLabel(const IrOperand& label)
+{
+	blocks.push_back( { label } );
+}
+
+void IrBody::endStatement()
+{
+	for (size_t i = blocks.size(); i-- > 0;)
+		if (!blocks[i].instructions.empty())
+		{
+			blocks[i].instructions.back().blankLine = true;
+			return;
+		}
+}
+
+std::string_view IrBody::addText(std::string text)
+{
+	return texts.emplace_back(std::move(text));
+}
+
+void IrBody::clear()
+{
+	blocks.clear();
+	texts.clear();
+}
+
+static const char* getOpName(const IrOp& op)
+{
+	switch (op)
+	{
+		case IrOp::IR_IMM:   return "IMM";
+		case IrOp::IR_MOV:   return "MOV";
+		case IrOp::IR_LOAD:  return "LLOD";
+		case IrOp::IR_STORE: return "LSTR";
+		case IrOp::IR_PUSH:  return "PSH";
+		case IrOp::IR_ADD:   return "ADD";
+		case IrOp::IR_SUB:   return "SUB";
+		case IrOp::IR_MLT:   return "MLT";
+		case IrOp::IR_DIV:   return "DIV";
+		case IrOp::IR_MOD:   return "MOD";
+		case IrOp::IR_AND:   return "AND";
+		case IrOp::IR_CALL:  return "CAL";
+		default:             return "";
+	}
+}
+
+static const char* getBranchName(const IrCond& cond)
+{
+	switch (cond)
+	{
+		case IrCond::IC_EQ: return "BRE";
+		case IrCond::IC_NE: return "BNE";
+		case IrCond::IC_GT: return "BRG";
+		case IrCond::IC_GE: return "BGE";
+		case IrCond::IC_LT: return "BRL";
+		case IrCond::IC_LE: return "BLE";
+		default:            return "";
+	}
+}
+
+static void printLabel(const IrOperand& label, OutputBuffer& code, std::vector<Relocation>& relocations)
+{
+	RelocationType type = RelocationType::RT_IF_LABEL;
+	switch (label.label)
+	{
+		case IrLabelKind::IL_IF:       code << ".if";       type = RelocationType::RT_IF_LABEL; break;
+		case IrLabelKind::IL_ENDIF:    code << ".endif";    type = RelocationType::RT_IF_LABEL; break;
+		case IrLabelKind::IL_WHILE:    code << ".while";    type = RelocationType::RT_WHILE_LABEL; break;
+		case IrLabelKind::IL_ENDWHILE: code << ".endwhile"; type = RelocationType::RT_WHILE_LABEL; break;
+		case IrLabelKind::IL_STRING:   code << ".str";      type = RelocationType::RT_STRING_LABEL; break;
+
+		case IrLabelKind::IL_FUNCTION:
+			code << '.' << label.text;
+			return;
+	}
+
+	relocations.push_back( { code.size(), type, label.number, label.text } );
+	code << label.number;
+}
+
+static void printOperand(const IrOperand& operand, OutputBuffer& code, std::vector<Relocation>& relocations)
+{
+	switch (operand.kind)
+	{
+		case IrOperandKind::IO_NONE:  break;
+		case IrOperandKind::IO_REG:   code << 'R' << operand.number; break;
+		case IrOperandKind::IO_IMM:   code << operand.text; break;
+		case IrOperandKind::IO_FLOAT: code << operand.text << "f32"; break;
+		case IrOperandKind::IO_LOCAL: code << "R1 -" << operand.number; break;
+		case IrOperandKind::IO_ARG:   code << "R1 " << operand.number + 1; break;
+		case IrOperandKind::IO_COUNT: code << operand.number; break;
+		case IrOperandKind::IO_LABEL: printLabel(operand, code, relocations); break;
+	}
+}
+
+static void printInstruction(const IrInstruction& instruction, OutputBuffer& code, std::vector<Relocation>& relocations)
+{
+	switch (instruction.op)
+	{
+		case IrOp::IR_ALLOC:
+			code << "DEC SP SP\n";
+			break;
+
+		case IrOp::IR_FREE:
+			code << "ADD SP SP ";
+			printOperand(instruction.a, code, relocations);
+			code << '\n';
+			break;
+
+		case IrOp::IR_RET:
+			// cdecl calling convention exit
+			code << "MOV SP R1\nPOP R1\nRET\n";
+			break;
+
+		case IrOp::IR_BRANCH:
+			code << getBranchName(instruction.cond) << ' ';
+			printLabel(instruction.dst, code, relocations);
+			code << ' ';
+			printOperand(instruction.a, code, relocations);
+			code << ' ';
+			printOperand(instruction.b, code, relocations);
+			code << '\n';
+			break;
+
+		case IrOp::IR_JMP:
+			code << "JMP ";
+			printLabel(instruction.dst, code, relocations);
+			code << '\n';
+			break;
+
+		case IrOp::IR_URCL:
+			code << instruction.a.text << '\n';
+			break;
+
+		case IrOp::IR_COMMENT:
+			code << "// " << instruction.a.text << '\n';
+			break;
+
+		default:
+		{
+			code << getOpName(instruction.op);
+			for (const IrOperand* operand: { &instruction.dst, &instruction.a, &instruction.b })
+			{
+				if (operand->kind == IrOperandKind::IO_NONE)
+					continue;
+
+				code << ' ';
+				printOperand(*operand, code, relocations);
+			}
+			code << '\n';
+			break;
+		}
+	}
+
+	if (instruction.blankLine)
+		code << '\n';
+}
+
+void printIr(const IrBody& body, OutputBuffer& code, std::vector<Relocation>& relocations)
+{
+	for (const IrBlock& block: body.blocks)
+	{
+		if (block.label.kind == IrOperandKind::IO_LABEL)
+		{
+			printLabel(block.label, code, relocations);
+			code << '\n';
+		}
+
+		for (const IrInstruction& instruction: block.instructions)
+			printInstruction(instruction, code, relocations);
+	}
+}
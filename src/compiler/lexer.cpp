@@ -1,53 +1,30 @@
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <algorithm>
 
 #include <compiler/lexer.h>
+#include <compiler/keywords.h>
+#include <compiler/charScan.h>
 #include <util.h>
 
-// Global source variable for the compile function to print errors
-std::string glob_src;
-
 //--------------------------------//
 //		  LEXER
 //--------------------------------//
-const std::string SignedIntTypes[] =
-{
-	"int8",
-	"int16",
-	"int32",
-	"int64"
-};
-
-const std::string UnsignedIntTypes[] =
-{
-	"uint8",
-	"uint16",
-	"uint32",
-	"uint64"
-};
-
-const std::string FloatTypes[] =
-{
-	"float32",
-	"float64"
-};
-
 class Buffer
 {
 private:
-	std::string m_data;
+	std::string_view m_data;
 	size_t m_index = 0;
 
 public:
-	Buffer(const std::string &data)
+	Buffer(std::string_view data)
 		: m_data(data)
 	{}
 
 	bool hasNext() const
 	{
-		return m_index < m_data.size() - 1;
+		return m_index < m_data.size();
 	}
 
 	void advance()
@@ -62,76 +39,73 @@ public:
 
 	char current() const
 	{
-		return m_data[m_index];
+		return m_index < m_data.size() ? m_data[m_index] : '\0';
+	}
+
+	char peek() const
+	{
+		return m_index + 1 < m_data.size() ? m_data[m_index + 1] : '\0';
 	}
 
 	size_t pos() const
 	{
 		return m_index;
 	}
+
+	void seek(size_t pos)
+	{
+		m_index = pos;
+	}
+
+	std::string_view data() const
+	{
+		return m_data;
+	}
+
+	std::string_view slice(size_t start, size_t length) const
+	{
+		return m_data.substr(start, length);
+	}
 };
 
 struct TokenTypeAndWord
 {
 	TokenType tokType;
-	std::string word;
+	std::string_view word;
 
 	size_t start;
 	size_t end;
 };
 
-TokenTypeAndWord makeWord(const char& data, Buffer& buf, const std::string& source, const size_t& lineno)
+TokenTypeAndWord makeWord(const char& data, Buffer& buf, const SourceFile& source, const size_t& lineno)
 {
-	std::string word;
-
-	size_t start = buf.pos() - find_nth(source, '\n', lineno - 1);
-	size_t end = start;
-
-	while (buf.hasNext())
-	{
-		const char& curr = buf.current();
-
-		if (curr == ' ')                                  break;
-		if (!isalnum(curr) && curr != '_' && curr != '-') break;
-
-		word += curr;
-		end++;
-
-		buf.advance();
-	}
-
-	if (word == "void") return { TokenType::TT_VOID, word, start, end };
+	const size_t wordStart = buf.pos();
+	buf.seek(scanWord(buf.data(), wordStart));
 
-	else if (std::find(std::begin(SignedIntTypes), std::end(SignedIntTypes), word) != std::end(SignedIntTypes))
-		return { TokenType::TT_INT, word, start, end };
-	
-	else if (std::find(std::begin(UnsignedIntTypes), std::end(UnsignedIntTypes), word) != std::end(UnsignedIntTypes))
-		return { TokenType::TT_UINT, word, start, end };
+	size_t start = source.getColumn(wordStart, lineno);
+	size_t end = start + (buf.pos() - wordStart);
 
-	else if (std::find(std::begin(FloatTypes), std::end(FloatTypes), word) != std::end(FloatTypes))
-		return { TokenType::TT_FLOAT, word, start, end };
+	const std::string_view word = buf.slice(wordStart, buf.pos() - wordStart);
 
-	else if (word == "string") return { TokenType::TT_STRING,     word, start, end };
-	else if (word == "char")   return { TokenType::TT_CHARACTER,  word, start, end };
+	if (const Keyword* keyword = findKeyword(word))
+		return { keyword->type,         word, start, end };
 
-	else if (word == "if")     return { TokenType::TT_IF,         word, start, end };
-	else if (word == "else")   return { TokenType::TT_ELSE,       word, start, end };
-	else if (word == "while")  return { TokenType::TT_WHILE,      word, start, end };
-
-	else if (word == "import") return { TokenType::TT_IMPORT,     word, start, end };
+	return     { TokenType::TT_IDENTIFIER, word, start, end };
+}
 
-	else if (word == "urcl")   return { TokenType::TT_URCL_BLOCK, word, start, end };
-	else if (word == "return") return { TokenType::TT_RETURN,     word, start, end };
+// Reports an error and skips the rest of its line, lexing carries on at the newline
+static void lexError(Diagnostics& diagnostics, Buffer& buf, const SourceFile& source, const std::string& message, const size_t& lineno, const size_t& start, const size_t& end)
+{
+	diagnostics.error(source, message, lineno, start, end);
 
-	else                       return { TokenType::TT_IDENTIFIER, word, start, end };
+	const size_t newline = buf.data().find('\n', buf.pos());
+	buf.seek(newline == std::string_view::npos ? buf.data().size() : newline);
 }
 
-std::vector<Token> tokenize(std::string source)
+std::vector<Token> tokenize(const SourceFile& source, Diagnostics& diagnostics)
 {
-	glob_src = source;
-
 	std::vector<Token> toks;
-	Buffer buf(source);
+	Buffer buf(source.getSource());
 
 	size_t lineno = 1;
 
@@ -139,9 +113,17 @@ std::vector<Token> tokenize(std::string source)
 	{
 		const char& data = buf.current();
 
-		if (data == ' ')
+		if (data == ' ' || data == '\t' || data == '\r')
 		{
-			buf.advance();
+			buf.seek(scanBlanks(buf.data(), buf.pos()));
+			continue;
+		}
+
+		// Comments run until the end of the line, the newline itself is still lexed for line counting
+		else if (data == '/' && buf.peek() == '/')
+		{
+			const size_t newline = buf.data().find('\n', buf.pos());
+			buf.seek(newline == std::string_view::npos ? buf.data().size() : newline);
 			continue;
 		}
 
@@ -150,8 +132,8 @@ std::vector<Token> tokenize(std::string source)
 
 		else if (data == ';')
 			toks.push_back(Token(lineno, TokenType::TT_SEMICOLON, ";",
-								 buf.pos() - find_nth(source, '\n', lineno - 1),
-								 buf.pos() - find_nth(source, '\n', lineno - 1)));
+								 source.getColumn(buf.pos(), lineno),
+								 source.getColumn(buf.pos(), lineno)));
 
 		else if (data == '=')
 		{
@@ -159,64 +141,64 @@ std::vector<Token> tokenize(std::string source)
 			{
 				buf.advance();
 				if (buf.current() == '=')
-					toks.push_back(Token(lineno, TokenType::TT_EQ, ";",
-								 buf.pos() - find_nth(source, '\n', lineno - 1) - 1,
-								 buf.pos() - find_nth(source, '\n', lineno - 1)));
+					toks.push_back(Token(lineno, TokenType::TT_EQ, "==",
+								 source.getColumn(buf.pos(), lineno) - 1,
+								 source.getColumn(buf.pos(), lineno)));
 				else
-					toks.push_back(Token(lineno, TokenType::TT_ASSIGN, ";",
-								 buf.pos() - find_nth(source, '\n', lineno - 1),
-								 buf.pos() - find_nth(source, '\n', lineno - 1)));
+					toks.push_back(Token(lineno, TokenType::TT_ASSIGN, "=",
+								 source.getColumn(buf.pos(), lineno),
+								 source.getColumn(buf.pos(), lineno)));
 			}
 		}
 
 		else if (data == '+')
-			toks.push_back(Token(lineno, TokenType::TT_PLUS, std::string(1, data),
-								 buf.pos() - find_nth(source, '\n', lineno - 1),
-								 buf.pos() - find_nth(source, '\n', lineno - 1)));
+			toks.push_back(Token(lineno, TokenType::TT_PLUS, buf.slice(buf.pos(), 1),
+								 source.getColumn(buf.pos(), lineno),
+								 source.getColumn(buf.pos(), lineno)));
 		else if (data == '-')
-			toks.push_back(Token(lineno, TokenType::TT_MINUS, std::string(1, data),
-								 buf.pos() - find_nth(source, '\n', lineno - 1),
-								 buf.pos() - find_nth(source, '\n', lineno - 1)));
+			toks.push_back(Token(lineno, TokenType::TT_MINUS, buf.slice(buf.pos(), 1),
+								 source.getColumn(buf.pos(), lineno),
+								 source.getColumn(buf.pos(), lineno)));
 		else if (data == '*')
-			toks.push_back(Token(lineno, TokenType::TT_MULT, std::string(1, data),
-								 buf.pos() - find_nth(source, '\n', lineno - 1),
-								 buf.pos() - find_nth(source, '\n', lineno - 1)));
+			toks.push_back(Token(lineno, TokenType::TT_MULT, buf.slice(buf.pos(), 1),
+								 source.getColumn(buf.pos(), lineno),
+								 source.getColumn(buf.pos(), lineno)));
 		else if (data == '/')
-			toks.push_back(Token(lineno, TokenType::TT_DIV, std::string(1, data),
-								 buf.pos() - find_nth(source, '\n', lineno - 1),
-								 buf.pos() - find_nth(source, '\n', lineno - 1)));
+			toks.push_back(Token(lineno, TokenType::TT_DIV, buf.slice(buf.pos(), 1),
+								 source.getColumn(buf.pos(), lineno),
+								 source.getColumn(buf.pos(), lineno)));
 		else if (data == '%')
-			toks.push_back(Token(lineno, TokenType::TT_MOD, std::string(1, data),
-								 buf.pos() - find_nth(source, '\n', lineno - 1),
-								 buf.pos() - find_nth(source, '\n', lineno - 1)));
+			toks.push_back(Token(lineno, TokenType::TT_MOD, buf.slice(buf.pos(), 1),
+								 source.getColumn(buf.pos(), lineno),
+								 source.getColumn(buf.pos(), lineno)));
 
 		else if (data == '(')
-			toks.push_back(Token(lineno, TokenType::TT_OPEN_PAREN, std::string(1, data),
-								 buf.pos() - find_nth(source, '\n', lineno - 1),
-								 buf.pos() - find_nth(source, '\n', lineno - 1)));
+			toks.push_back(Token(lineno, TokenType::TT_OPEN_PAREN, buf.slice(buf.pos(), 1),
+								 source.getColumn(buf.pos(), lineno),
+								 source.getColumn(buf.pos(), lineno)));
 		else if (data == ')')
-			toks.push_back(Token(lineno, TokenType::TT_CLOSE_PAREN, std::string(1, data),
-								 buf.pos() - find_nth(source, '\n', lineno - 1),
-								 buf.pos() - find_nth(source, '\n', lineno - 1)));
+			toks.push_back(Token(lineno, TokenType::TT_CLOSE_PAREN, buf.slice(buf.pos(), 1),
+								 source.getColumn(buf.pos(), lineno),
+								 source.getColumn(buf.pos(), lineno)));
 
 		else if (data == ',')
 		{
-			toks.push_back(Token(lineno, TokenType::TT_COMMA, std::string(1, data),
-								 buf.pos() - find_nth(source, '\n', lineno - 1),
-								 buf.pos() - find_nth(source, '\n', lineno - 1)));
+			toks.push_back(Token(lineno, TokenType::TT_COMMA, buf.slice(buf.pos(), 1),
+								 source.getColumn(buf.pos(), lineno),
+								 source.getColumn(buf.pos(), lineno)));
 		}
 
 		else if (data == '{')
 		{
-			toks.push_back(Token(lineno, TokenType::TT_OPEN_BRACE, std::string(1, data),
-								 buf.pos() - find_nth(source, '\n', lineno - 1),
-								 buf.pos() - find_nth(source, '\n', lineno - 1)));
+			toks.push_back(Token(lineno, TokenType::TT_OPEN_BRACE, buf.slice(buf.pos(), 1),
+								 source.getColumn(buf.pos(), lineno),
+								 source.getColumn(buf.pos(), lineno)));
 		}
 		else if (data == '}')
 		{
-			toks.push_back(Token(lineno, TokenType::TT_CLOSE_BRACE, std::string(1, data),
-								 buf.pos() - find_nth(source, '\n', lineno - 1),
-								 buf.pos() - find_nth(source, '\n', lineno - 1)));
+			toks.push_back(Token(lineno, TokenType::TT_CLOSE_BRACE, buf.slice(buf.pos(), 1),
+								 source.getColumn(buf.pos(), lineno),
+								 source.getColumn(buf.pos(), lineno)));
 		}
 
 		else if (data == '>')
@@ -226,12 +208,12 @@ std::vector<Token> tokenize(std::string source)
 				buf.advance();
 				if (buf.current() == '=')
 					toks.push_back(Token(lineno, TokenType::TT_GTE, ">=",
-										buf.pos() - find_nth(source, '\n', lineno - 1) - 1,
-										buf.pos() - find_nth(source, '\n', lineno - 1)));
+										source.getColumn(buf.pos(), lineno) - 1,
+										source.getColumn(buf.pos(), lineno)));
 				else
 					toks.push_back(Token(lineno, TokenType::TT_GT, ">",
-										buf.pos() - find_nth(source, '\n', lineno - 1),
-										buf.pos() - find_nth(source, '\n', lineno - 1)));
+										source.getColumn(buf.pos(), lineno),
+										source.getColumn(buf.pos(), lineno)));
 			}
 		}
 
@@ -242,12 +224,12 @@ std::vector<Token> tokenize(std::string source)
 				buf.advance();
 				if (buf.current() == '=')
 					toks.push_back(Token(lineno, TokenType::TT_LTE, "<=",
-										buf.pos() - find_nth(source, '\n', lineno - 1) - 1,
-										buf.pos() - find_nth(source, '\n', lineno - 1)));
+										source.getColumn(buf.pos(), lineno) - 1,
+										source.getColumn(buf.pos(), lineno)));
 				else
 					toks.push_back(Token(lineno, TokenType::TT_LT, "<",
-											buf.pos() - find_nth(source, '\n', lineno - 1),
-											buf.pos() - find_nth(source, '\n', lineno - 1)));
+											source.getColumn(buf.pos(), lineno),
+											source.getColumn(buf.pos(), lineno)));
 			}
 		}
 
@@ -258,133 +240,143 @@ std::vector<Token> tokenize(std::string source)
 				buf.advance();
 				if (buf.current() == '=')
 					toks.push_back(Token(lineno, TokenType::TT_NEQ, "!=",
-										buf.pos() - find_nth(source, '\n', lineno - 1),
-										buf.pos() - find_nth(source, '\n', lineno - 1)));
+										source.getColumn(buf.pos(), lineno),
+										source.getColumn(buf.pos(), lineno)));
 				else continue;
 			}
 		}
 
 		else if (data == '\'')
 		{
-			const size_t& start = buf.pos() - find_nth(source, '\n', lineno - 1);
+			const size_t& start = source.getColumn(buf.pos(), lineno);
 
 			buf.advance();
-			char _char;
+			std::string_view _char;
 
 			if (buf.current() == '\\')
 			{
 				buf.advance();
-				_char = buf.current();
-
-				if (_char == 'n')
-					_char = '\n';
-				else if (_char == 't')
-					_char = '\t';
-				else if (_char == '\'')
-					_char = '\'';
-				else if (_char == '\\')
-					_char = '\\';
+
+				if (buf.current() == 'n')
+					_char = "\n";
+				else if (buf.current() == 't')
+					_char = "\t";
+				else if (buf.current() == '\'')
+					_char = "'";
+				else if (buf.current() == '\\')
+					_char = "\\";
 				else
 				{
-					std::cerr << "Invalid escape sequence at line " << lineno << '\n';
-					std::cerr << lineno << ": " << getSourceLine(source, lineno);
-					drawArrows(
-						buf.pos() - find_nth(source, '\n', lineno - 1) - 1,
-						buf.pos() - find_nth(source, '\n', lineno - 1),
-						lineno
-					);
-					exit(-1);
+					lexError(diagnostics, buf, source, "Invalid escape sequence", lineno,
+							 source.getColumn(buf.pos(), lineno) - 1,
+							 source.getColumn(buf.pos(), lineno));
+					continue;
 				}
 			}
 			else
-				_char = buf.current();
+				_char = buf.slice(buf.pos(), 1);
 
 			buf.advance();
 			if (buf.current() != '\'')
 			{
-				std::cerr << "Expected closing ' for character literal at line " << lineno << '\n';
-				std::cerr << lineno << ": " << getSourceLine(source, lineno);
-				drawArrows(
-					buf.pos() - find_nth(source, '\n', lineno - 1),
-					buf.pos() - find_nth(source, '\n', lineno - 1),
-					lineno
-				);
-				exit(-1);
+				lexError(diagnostics, buf, source, "Expected closing ' for character literal", lineno,
+						 source.getColumn(buf.pos(), lineno),
+						 source.getColumn(buf.pos(), lineno));
+				continue;
 			}
 
-			const size_t& end = buf.pos() - find_nth(source, '\n', lineno - 1);
+			const size_t& end = source.getColumn(buf.pos(), lineno);
 
-			toks.push_back(Token(lineno, TokenType::TT_CHAR, std::string(1, _char), start, end));
+			toks.push_back(Token(lineno, TokenType::TT_CHAR, _char, start, end));
 		}
 
 		else if (data == '"')
 		{
-			const size_t& start = buf.pos() - find_nth(source, '\n', lineno - 1);
+			const size_t& start = source.getColumn(buf.pos(), lineno);
 
-			std::string str;
+			// Literals without escapes are viewed straight from the source,
+			// only escaped ones need their decoded text stored
+			const size_t strStart = buf.pos() + 1;
+			bool hasEscapes = false;
+			bool valid = true;
+			std::string decoded;
 
 			buf.advance();
-			while (buf.current() != '"')
+			while (true)
 			{
+				// Jump over plain characters, only quotes, escapes and newlines need a closer look
+				const size_t runEnd = scanStringBody(buf.data(), buf.pos());
+				if (hasEscapes)
+					decoded += buf.slice(buf.pos(), runEnd - buf.pos());
+				buf.seek(runEnd);
+
+				if (buf.current() == '"')
+					break;
+
 				if (buf.current() == '\\')
 				{
+					if (!hasEscapes)
+					{
+						decoded = buf.slice(strStart, buf.pos() - strStart);
+						hasEscapes = true;
+					}
+
 					buf.advance();
 					if (buf.current() == 'n')
-						str += '\n';
+						decoded += '\n';
 					else if (buf.current() == 't')
-						str += '\t';
+						decoded += '\t';
 					else if (buf.current() == '\\')
-						str += '\\';
+						decoded += '\\';
 					else if (buf.current() == '"')
-						str += '"';
+						decoded += '"';
 					else
 					{
-						std::cerr << "Unknown escape sequence at line " << lineno << '\n';
-						std::cerr << lineno << ": " << getSourceLine(source, lineno);
-						drawArrows(
-							buf.pos() - find_nth(source, '\n', lineno - 1),
-							buf.pos() - find_nth(source, '\n', lineno - 1),
-							lineno
-						);
-						exit(-1);
+						lexError(diagnostics, buf, source, "Unknown escape sequence", lineno,
+								 source.getColumn(buf.pos(), lineno),
+								 source.getColumn(buf.pos(), lineno));
+						valid = false;
+						break;
 					}
 				}
 
-				else if (buf.current() == '\n')
+				// Newline or end of the source
+				else
 				{
-					std::cerr << "Unterminated string at line " << lineno << '\n';
-					std::cerr << lineno << ": " << getSourceLine(source, lineno);
-					drawArrows(
-						buf.pos() - find_nth(source, '\n', lineno - 1) - 2,
-						buf.pos() - find_nth(source, '\n', lineno - 1) - 2,
-						lineno
-					);
-					exit(-1);
+					lexError(diagnostics, buf, source, "Unterminated string", lineno,
+							 source.getColumn(buf.pos(), lineno) - 1,
+							 source.getColumn(buf.pos(), lineno) - 1);
+					valid = false;
+					break;
 				}
 
-				else
-					str += buf.current();
-
 				buf.advance();
 			}
 
-			const size_t& end = buf.pos() - find_nth(source, '\n', lineno - 1);
+			if (!valid)
+				continue;
+
+			const std::string_view str = hasEscapes
+				? internTokenText(decoded)
+				: buf.slice(strStart, buf.pos() - strStart);
+
+			const size_t& end = source.getColumn(buf.pos(), lineno);
 
 			toks.push_back(Token(lineno, TokenType::TT_STR, str, start, end));
 		}
 
 		else if (data == '.')
 		{
-			toks.push_back(Token(lineno, TokenType::TT_DOT, std::string(1, data),
-								 buf.pos() - find_nth(source, '\n', lineno - 1),
-								 buf.pos() - find_nth(source, '\n', lineno - 1)));
+			toks.push_back(Token(lineno, TokenType::TT_DOT, buf.slice(buf.pos(), 1),
+								 source.getColumn(buf.pos(), lineno),
+								 source.getColumn(buf.pos(), lineno)));
 		}
 
 		else if (data == ':')
 		{
-			toks.push_back(Token(lineno, TokenType::TT_COLON, std::string(1, data),
-								 buf.pos() - find_nth(source, '\n', lineno - 1),
-								 buf.pos() - find_nth(source, '\n', lineno - 1)));
+			toks.push_back(Token(lineno, TokenType::TT_COLON, buf.slice(buf.pos(), 1),
+								 source.getColumn(buf.pos(), lineno),
+								 source.getColumn(buf.pos(), lineno)));
 		}
 
 		else if (isalpha(data) || data == '_')
@@ -396,24 +388,13 @@ std::vector<Token> tokenize(std::string source)
 
 		else if (isdigit(data))
 		{
-			std::string word = "";
+			const size_t wordStart = buf.pos();
+			buf.seek(scanDigits(buf.data(), wordStart));
 
-			size_t start = buf.pos() - find_nth(source, '\n', lineno - 1);
-			size_t end = start;
-
-			while (buf.hasNext())
-			{
-				if (buf.current() == ';') break;
-
-				if (!isdigit(buf.current()))
-					break;
-
-				word += buf.current();
-				end++;
-
-				buf.advance();
-			}
+			size_t start = source.getColumn(wordStart, lineno);
+			size_t end = start + (buf.pos() - wordStart);
 
+			const std::string_view word = buf.slice(wordStart, buf.pos() - wordStart);
 			toks.push_back(Token(lineno, TokenType::TT_NUM, word, start, end));
 
 			continue;
@@ -421,12 +402,10 @@ std::vector<Token> tokenize(std::string source)
 
 		else
 		{
-			std::cerr << "Invalid syntax at line " << lineno << '\n';
-			std::cerr << lineno << ": " << getSourceLine(source, lineno);
-			size_t i = buf.pos() - find_nth(source, '\n', lineno - 1);
-			size_t j = source.find_first_of(' ', i);
-			drawArrows(i, j, lineno);
-			exit(-1);
+			size_t i = source.getColumn(buf.pos(), lineno);
+			size_t j = source.getLine(lineno).find_first_of(' ', i);
+			lexError(diagnostics, buf, source, "Invalid syntax", lineno, i, j);
+			continue;
 		}
 
 		buf.advance();
@@ -1,111 +1,127 @@
 #include <compiler/linker.h>
 
-#include <iostream>
+#include <sstream>
 
 #include <compiler/parser.h>
 #include <compiler/token.h>
+#include <compiler/keywords.h>
+#include <compiler/timeReport.h>
 #include <util.h>
 
 struct LenghtEncodedType
 {
 	const size_t len;
-	const std::string val;
+	const std::string_view val;
 };
 
 const LenghtEncodedType encodeType(const Token& typeName)
 {
-	const size_t len = typeName.m_val.length();
-	(void) len; // Temporary
+	const Keyword* keyword = findKeyword(typeName.m_val);
+	if (keyword == nullptr || keyword->type != typeName.m_type || keyword->mangled.empty())
+		return { 0, "" };
 
-	switch (typeName.m_type)
-	{
-		case TokenType::TT_VOID:           return { size_t(-1), "v" };
-		case TokenType::TT_INT:
-		{
-			if (typeName.m_val == "int8")  return { size_t(-1), "i8"  };
-			if (typeName.m_val == "int16") return { size_t(-1), "i16" };
-			if (typeName.m_val == "int32") return { size_t(-1), "i32" };
-		}
-		case TokenType::TT_UINT:
-		{
-			if (typeName.m_val == "uint8")  return { size_t(-1), "u8"  };
-			if (typeName.m_val == "uint16") return { size_t(-1), "u16" };
-			if (typeName.m_val == "uint32") return { size_t(-1), "u32" };
-		}
-		case TokenType::TT_FLOAT:
-		{
-			if (typeName.m_val == "float32") return { size_t(-1), "f32" };
-			if (typeName.m_val == "float64") return { size_t(-1), "f64" };
-		}
-		case TokenType::TT_STRING:    return { size_t(-1), "s" };
-		case TokenType::TT_CHARACTER: return { size_t(-1), "c" };
-		
-		default:
-			return { 0, "" };
-	}
+	return { size_t(-1), keyword->mangled };
 }
 
-const std::string Function::getSignature() const
+static void appendType(std::string& signature, const Token& type)
 {
-	std::stringstream ss;
+	const LenghtEncodedType& encoded = encodeType(type);
+	if (encoded.len != size_t(-1))
+		signature += '_' + std::to_string(encoded.len);
 
-	ss << "_Hx" /* Hexagn mangled name signature */ << name.m_val.length() << name.m_val;
+	signature += encoded.val;
+}
 
-	const LenghtEncodedType& _return = encodeType(returnType);
-	if (_return.len == size_t(-1))
-		ss << _return.val;
-	else
-		ss << '_' << _return.len << _return.val;
+const std::string& Function::getSignature() const
+{
+	if (!signature.empty())
+		return signature;
+
+	signature = "_Hx" /* Hexagn mangled name signature */ + std::to_string(name.m_val.length());
+	signature += name.m_val;
 
+	appendType(signature, returnType);
 	for (const auto& arg: argTypes)
+		appendType(signature, arg);
+
+	return signature;
+}
+
+static Token ownedToken(const Token& tok)
+{
+	Token owned = tok;
+	owned.m_val = internTokenText(tok.m_val);
+	return owned;
+}
+
+static void writePreviousDefinition(std::ostream& out, const SourceFile& src, const Function& func)
+{
+	out << "Previous definition:\n";
+	out << func.returnType.m_lineno << ": " << getSourceLine(src, func.returnType.m_lineno);
+	if (func.name.m_lineno != func.returnType.m_lineno)
 	{
-		const LenghtEncodedType& var = encodeType(arg);
-		if (var.len == size_t(-1))
-			ss << var.val;
-		else
-			ss << '_' << var.len << var.val;
+		out << func.name.m_lineno << ": " << getSourceLine(src, func.name.m_lineno);
+		out << getArrows(func.name.m_start, func.name.m_end, func.name.m_lineno);
 	}
-
-	return ss.str();
+	else
+		out << getArrows(func.returnType.m_start, func.name.m_end, func.returnType.m_lineno);
 }
 
-void Linker::addFunction(const Function& function)
+Linker::Linker(CompilerContext& context)
+	: context(context)
+{}
+
+size_t Linker::addFunction(const Function& function)
 {
+	PhaseTimer timer(context.timeReport, Phase::PH_LINKER);
+	const std::string& signature = function.getSignature();
+
 	// Check for duplicate function
-	for (const auto& func: linkerFunctions)
+	const auto duplicate = signatureIndex.find(signature);
+	if (duplicate != signatureIndex.end())
 	{
-		if (func.getSignature() == function.getSignature())
-		{
-			std::cerr << "Error: Duplicate function '" << function.name.m_val << "'\n";
-			std::cerr << "Previous definition:\n";
-			std::cerr << func.returnType.m_lineno << ": " << getSourceLine(glob_src, func.returnType.m_lineno);
-			if (func.name.m_lineno != func.returnType.m_lineno)
-			{
-				std::cerr << func.name.m_lineno << ": " << getSourceLine(glob_src, func.name.m_lineno);
-				drawArrows(func.name.m_start, func.name.m_end, func.name.m_lineno);
-			}
-			else
-				drawArrows(func.returnType.m_start, func.name.m_end, func.returnType.m_lineno);
-			exit(-1);
-		}
+		std::ostringstream error;
+		error << "Error: Duplicate function '" << function.name.m_val << "'\n";
+		writePreviousDefinition(error, context.src, linkerFunctions[duplicate->second]);
+		context.diagnostics.error(error.str());
+		return duplicate->second;
+	}
 
-		if (func.name.m_val == function.name.m_val && func.returnType.toString() != function.returnType.toString() && func.argTypes == function.argTypes)
+	if (const std::vector<size_t>* overloads = getOverloads(function.name.m_val, function.argTypes.size()))
+		for (const size_t& index: *overloads)
 		{
-			std::cerr << "Cannot have functions with same arguments but different return types: " << function.name.m_val << '\n';
-			std::cerr << "Previous definition:\n";
-			std::cerr << func.returnType.m_lineno << ": " << getSourceLine(glob_src, func.returnType.m_lineno);
-			if (func.name.m_lineno != func.returnType.m_lineno)
+			const Function& func = linkerFunctions[index];
+			if (!(func.returnType == function.returnType) && func.argTypes == function.argTypes)
 			{
-				std::cerr << func.name.m_lineno << ": " << getSourceLine(glob_src, func.name.m_lineno);
-				drawArrows(func.name.m_start, func.name.m_end, func.name.m_lineno);
+				std::ostringstream error;
+				error << "Cannot have functions with same arguments but different return types: " << function.name.m_val << '\n';
+				writePreviousDefinition(error, context.src, func);
+				context.diagnostics.error(error.str());
+				return index;
 			}
-			else
-				drawArrows(func.returnType.m_start, func.name.m_end, func.name.m_lineno);
-			exit(-1);
 		}
-	}
 
-	linkerFunctions.push_back(function);
+	// Functions outlive the source they were parsed from, so their tokens get their own text
+	Function stored { ownedToken(function.name), ownedToken(function.returnType), function.argTypes, function.code, signature };
+	for (auto& arg: stored.argTypes)
+		arg = ownedToken(arg);
+
+	const size_t index = linkerFunctions.size();
+	signatureIndex.emplace(signature, index);
+
+	std::vector<std::vector<size_t>>& arities = nameIndex[stored.name.m_val];
+	if (arities.size() <= stored.argTypes.size())
+		arities.resize(stored.argTypes.size() + 1);
+	arities[stored.argTypes.size()].push_back(index);
+
+	linkerFunctions.push_back(std::move(stored));
+	return index;
+}
+
+void Linker::setFunctionCode(const size_t& index, const OutputBuffer& code)
+{
+	PhaseTimer timer(context.timeReport, Phase::PH_LINKER);
+	linkerFunctions[index].code = code;
 }
 
 const std::string getTypeName(const Token& type)
@@ -113,10 +129,10 @@ const std::string getTypeName(const Token& type)
 	switch (type.m_type)
 	{
 		case TokenType::TT_VOID     : return "void";
-		case TokenType::TT_INT      : return type.m_val;
-		case TokenType::TT_UINT     : return type.m_val;
+		case TokenType::TT_INT      : return std::string(type.m_val);
+		case TokenType::TT_UINT     : return std::string(type.m_val);
 		case TokenType::TT_NUM      : return "int";
-		case TokenType::TT_FLOAT    : return type.m_val;
+		case TokenType::TT_FLOAT    : return std::string(type.m_val);
 		case TokenType::TT_STRING   : return "string";
 		case TokenType::TT_CHARACTER: return "char";
 
@@ -124,39 +140,95 @@ const std::string getTypeName(const Token& type)
 	}
 }
 
-const Function Linker::getFunction(const std::string& src, const Token& name, const std::vector<Token>& argTypes) const
+const std::vector<size_t>* Linker::getOverloads(std::string_view name, const size_t& arity) const
+{
+	const auto arities = nameIndex.find(name);
+	if (arities == nameIndex.end() || arity >= arities->second.size())
+		return nullptr;
+
+	return &arities->second[arity];
+}
+
+// Whether a call with these argument types can go to the function, both have the same arity
+static bool acceptsArguments(const Function& func, const std::vector<Token>& argTypes)
 {
-	for (const auto& func: linkerFunctions)
+	for (size_t i = 0; i < func.argTypes.size(); ++i)
 	{
-		if (func.name.m_val == name.m_val)
+		if (isIntegerDataType(func.argTypes[i]))
 		{
-			if (func.argTypes.size() != argTypes.size()) break;
-			for (size_t i = 0; i < func.argTypes.size(); ++i)
+			if (!isIntegerDataType(argTypes[i]) && !isNumber(argTypes[i]))
+				return false;
+		}
+		else if (isFloatDataType(func.argTypes[i]) && !isFloatDataType(argTypes[i]))
+			return false;
+		else if (func.argTypes[i].m_type == TokenType::TT_STRING && argTypes[i].m_type != TokenType::TT_STRING)
+			return false;
+	}
+
+	return true;
+}
+
+const Function* Linker::findFunction(const Token& name, const std::vector<Token>& argTypes, const size_t& visibleCount) const
+{
+	PhaseTimer timer(context.timeReport, Phase::PH_LINKER);
+
+	// Matching only looks at the token types of the arguments. The buffer is kept
+	// per thread, so looking up a call does not allocate
+	static thread_local std::string key;
+	key.assign(name.m_val);
+	key += '(';
+	for (const Token& arg: argTypes)
+		key += char(arg.m_type);
+
+	// The cached function is the first match of all, if it is not visible no visible one matches either
+	{
+		std::shared_lock<std::shared_mutex> lock(resolutionMutex);
+		const auto cached = resolutionCache.find(key);
+		if (cached != resolutionCache.end())
+			return cached->second < visibleCount ? &linkerFunctions[cached->second] : nullptr;
+	}
+
+	// Functions are only added between code generation passes, so the overloads can be read without the lock
+	if (const std::vector<size_t>* overloads = getOverloads(name.m_val, argTypes.size()))
+		for (const size_t& index: *overloads)
+			if (acceptsArguments(linkerFunctions[index], argTypes))
 			{
-				if (isIntegerDataType(func.argTypes[i]))
-				{
-					if (!isIntegerDataType(argTypes[i]) && !isNumber(argTypes[i]))
-						goto nextFunc;
-				}
-				else if (isFloatDataType(func.argTypes[i]) && !isFloatDataType(argTypes[i]))
-					goto nextFunc;
-				else if (func.argTypes[i].m_type == TokenType::TT_STRING && argTypes[i].m_type != TokenType::TT_STRING)
-					goto nextFunc;
+				std::unique_lock<std::shared_mutex> lock(resolutionMutex);
+				resolutionCache.emplace(key, index);
+				return index < visibleCount ? &linkerFunctions[index] : nullptr;
 			}
 
-			return func;
-		}
+	return nullptr;
+}
 
-		nextFunc:;
-	}
+const Function& Linker::getFunction(Diagnostics& diagnostics, const SourceFile& src, const Token& name, const std::vector<Token>& argTypes, const size_t& visibleCount) const
+{
+	if (const Function* func = findFunction(name, argTypes, visibleCount))
+		return *func;
 
-	std::cerr << "Error: Function '" << name.m_val << "' with arguments ";
+	std::string message = "Error: Function '" + std::string(name.m_val) + "' with arguments ";
 	for (const Token& arg: argTypes)
-		std::cerr << getTypeName(arg) << ' ';
-	std::cerr << "does not exist at line " << name.m_lineno << '\n';
-	std::cerr << name.m_lineno << ": " << getSourceLine(src, name.m_lineno);
-	drawArrows(name.m_start, name.m_end, name.m_lineno);
-	exit(-1);
+		message += getTypeName(arg) + ' ';
+	message += "does not exist";
+
+	diagnostics.error(src, message, name);
+	throw CompileError();
+}
+
+void Linker::removeFunctionsFrom(const size_t& count)
+{
+	while (linkerFunctions.size() > count)
+	{
+		const Function& func = linkerFunctions.back();
+
+		signatureIndex.erase(func.getSignature());
+		nameIndex[func.name.m_val][func.argTypes.size()].pop_back();
+
+		linkerFunctions.pop_back();
+	}
+
+	std::unique_lock<std::shared_mutex> lock(resolutionMutex);
+	std::erase_if(resolutionCache, [&count](const auto& entry) { return entry.second >= count; });
 }
 
 const std::vector<Function>& Linker::getFunctions() const
@@ -0,0 +1,177 @@
+#include <compiler/memReport.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#include <sys/resource.h>
+#endif
+
+#include <compiler/parser.h>
+#include <compiler/timeReport.h>
+
+// Indexed by phase, the last entry counts allocations outside of every phase.
+// The counters belong to one report at a time, countingReport
+static std::atomic<const MemReport*> countingReport = nullptr;
+static std::atomic<bool> countingEnabled = false;
+static std::atomic<size_t> allocationCounts[size_t(Phase::PH_COUNT) + 1];
+static std::atomic<size_t> allocationBytes[size_t(Phase::PH_COUNT) + 1];
+
+void* operator new(std::size_t size)
+{
+	if (countingEnabled.load(std::memory_order_relaxed))
+	{
+		const size_t phase = size_t(getCurrentPhase());
+		allocationCounts[phase].fetch_add(1, std::memory_order_relaxed);
+		allocationBytes[phase].fetch_add(size, std::memory_order_relaxed);
+	}
+
+	if (size == 0)
+		size = 1;
+
+	while (true)
+	{
+		if (void* ptr = std::malloc(size))
+			return ptr;
+
+		const std::new_handler handler = std::get_new_handler();
+		if (handler == nullptr)
+			throw std::bad_alloc();
+		handler();
+	}
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+// Peak resident set size of the process in KiB, 0 where it can not be read
+static size_t getPeakRssKiB()
+{
+#if defined(_WIN32) || defined(__EMSCRIPTEN__)
+	return 0;
+#else
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#ifdef __APPLE__
+	// In bytes on macOS
+	return usage.ru_maxrss / 1024;
+#else
+	return usage.ru_maxrss;
+#endif
+#endif
+}
+
+static std::string formatRow(const char* name, const size_t& count, const size_t& bytes)
+{
+	char buffer[256];
+	std::snprintf(buffer, sizeof(buffer), "  %-40s %12zu %14zu\n", name, count, bytes);
+	return buffer;
+}
+
+MemReport::MemReport()
+{
+	// A report made while another one counts leaves its counters alone
+	const MemReport* expected = nullptr;
+	m_countsAllocations = countingReport.compare_exchange_strong(expected, this);
+	if (!m_countsAllocations)
+		return;
+
+	for (size_t i = 0; i <= size_t(Phase::PH_COUNT); ++i)
+	{
+		allocationCounts[i] = 0;
+		allocationBytes[i] = 0;
+	}
+	countingEnabled = true;
+}
+
+MemReport::~MemReport()
+{
+	if (!m_countsAllocations)
+		return;
+
+	countingEnabled = false;
+	countingReport = nullptr;
+}
+
+void MemReport::addTokens(const std::vector<Token>& tokens)
+{
+	size_t textBytes = 0;
+	for (const Token& tok: tokens)
+		textBytes += tok.m_val.size();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_tokens += tokens.size();
+	m_tokenTextBytes += textBytes;
+}
+
+void MemReport::addLocals(const size_t& peak)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_peakLocals = std::max(m_peakLocals, peak);
+}
+
+void MemReport::setOutput(const std::vector<Function>& functions, const StringTable& strings)
+{
+	size_t codeBytes = 0;
+	for (const Function& func: functions)
+		codeBytes += func.code.size();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_functions = functions.size();
+	m_functionCodeBytes = codeBytes;
+	m_strings = strings.getCount();
+	m_stringBytes = strings.getDataSize();
+}
+
+void MemReport::print(std::ostream& out) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	char header[256];
+	std::snprintf(header, sizeof(header), "  %-40s %12s %14s\n", "", "count", "bytes");
+
+	out << "Memory report\n" << header;
+	out << formatRow("tokens", m_tokens, m_tokens * sizeof(Token));
+	out << formatRow("token text", m_tokens, m_tokenTextBytes);
+	out << formatRow("linker functions", m_functions, m_functionCodeBytes);
+	out << formatRow("strings", m_strings, m_stringBytes);
+	out << "  peak locals in scope " << m_peakLocals << '\n';
+
+	const size_t peakRss = getPeakRssKiB();
+	if (peakRss != 0)
+		out << "  peak RSS " << peakRss << " KiB\n";
+
+	if (!m_countsAllocations)
+	{
+		out << "\nAllocations were not counted, another memory report was counting them\n";
+		return;
+	}
+
+	std::snprintf(header, sizeof(header), "  %-40s %12s %14s\n", "phase", "allocations", "bytes");
+	out << "\nAllocations\n" << header;
+
+	size_t totalCount = 0;
+	size_t totalBytes = 0;
+	for (size_t i = 0; i <= size_t(Phase::PH_COUNT); ++i)
+	{
+		const size_t count = allocationCounts[i].load(std::memory_order_relaxed);
+		const size_t bytes = allocationBytes[i].load(std::memory_order_relaxed);
+		out << formatRow(getPhaseName(Phase(i)), count, bytes);
+		totalCount += count;
+		totalBytes += bytes;
+	}
+	out << formatRow("total", totalCount, totalBytes);
+}
@@ -0,0 +1,81 @@
+#include <compiler/outputBuffer.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+
+constexpr size_t MAX_BLOCK_SIZE = 64 * 1024;
+
+OutputBuffer::Chunk& OutputBuffer::writableChunk(const size_t& needed)
+{
+	if (!m_chunks.empty())
+	{
+		Chunk& last = m_chunks.back();
+		if (last.data.use_count() == 1 && last.size < last.capacity)
+			return last;
+	}
+
+	const size_t capacity = std::max(m_nextCapacity, needed);
+	m_nextCapacity = std::min(m_nextCapacity * 2, MAX_BLOCK_SIZE);
+
+	m_chunks.push_back( { std::make_shared_for_overwrite<char[]>(capacity), 0, capacity } );
+	return m_chunks.back();
+}
+
+void OutputBuffer::append(std::string_view str)
+{
+	while (!str.empty())
+	{
+		// Long strings are split over full blocks rather than given one oversized block
+		Chunk& chunk = writableChunk(std::min(str.size(), MAX_BLOCK_SIZE));
+		const size_t count = std::min(str.size(), chunk.capacity - chunk.size);
+
+		std::memcpy(chunk.data.get() + chunk.size, str.data(), count);
+		chunk.size += count;
+		m_size += count;
+		str.remove_prefix(count);
+	}
+}
+
+void OutputBuffer::append(const OutputBuffer& other)
+{
+	if (&other == this)
+	{
+		const OutputBuffer copy = other;
+		append(copy);
+		return;
+	}
+
+	m_chunks.insert(m_chunks.end(), other.m_chunks.begin(), other.m_chunks.end());
+	m_size += other.m_size;
+
+	// Text written between two shared buffers is usually short
+	m_nextCapacity = MIN_BLOCK_SIZE;
+}
+
+size_t OutputBuffer::size() const
+{
+	return m_size;
+}
+
+std::string OutputBuffer::toString() const
+{
+	std::string str;
+	str.reserve(m_size);
+	for (const Chunk& chunk: m_chunks)
+		str.append(chunk.data.get(), chunk.size);
+
+	return str;
+}
+
+bool OutputBuffer::writeTo(std::FILE* file) const
+{
+	for (const Chunk& chunk: m_chunks)
+		if (std::fwrite(chunk.data.get(), 1, chunk.size, file) != chunk.size)
+			return false;
+
+	return true;
+}
@@ -3,15 +3,23 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <queue>
 #include <stack>
 #include <functional>
 #include <ranges>
+#include <span>
+#include <optional>
+#include <unordered_map>
 #include <math.h>
 
 #include <util.h>
+#include <compiler/ast.h>
+#include <compiler/ir.h>
 #include <compiler/linker.h>
+#include <compiler/keywords.h>
 #include <compiler/string.h>
+#include <compiler/cacheFile.h>
+#include <compiler/functionCache.h>
+#include <compiler/timeReport.h>
 #include <importer/importHelper.h>
 
 class TokenBuffer
@@ -51,62 +59,10 @@ public:
 	}
 };
 
-void VarStack::push(const std::string name, const Token type)
-{
-	if (!m_vars.empty())
-		m_vars.push_back( { name, m_vars[m_vars.size() - 1].stackOffset + 1, type } );
-	else
-		m_vars.push_back( { name, 1, type } );
-
-	frameCounter++;
-}
-
-void VarStack::pop()
-{
-	m_vars.pop_back();
-}
-
-void VarStack::pop(size_t num)
-{
-	for (size_t _ = 0; _ < num; ++_) m_vars.pop_back();
-}
-
-void VarStack::startFrame()
-{
-	frameCounter = 0;
-}
-
-const size_t VarStack::popFrame()
-{
-	pop(frameCounter);
-	return frameCounter;
-}
-
-const size_t VarStack::getOffset(const std::string& name) const
-{
-	for (const auto& var: m_vars)
-		if (var.name == name)
-			return var.stackOffset;
-	return -1;
-}
-
-const Token VarStack::getType(const std::string& name) const
-{
-	for (const auto& var: m_vars)
-		if (var.name == name)
-			return var.type;
-	return Token(-1, (TokenType) -1, "", -1, -1);
-}
-
-const size_t VarStack::getSize() const
-{
-	return m_vars.size();
-}
-
 struct VarStackFrame
 {
-	std::string val;
-	std::string code;
+	IrOperand val;
+	std::vector<IrInstruction> code;
 };
 
 bool operator ==(const Token& lhs, const Token& rhs)
@@ -114,22 +70,6 @@ bool operator ==(const Token& lhs, const Token& rhs)
 	return lhs.m_type == rhs.m_type && lhs.m_val == rhs.m_val;
 }
 
-bool isOperator(const Token& tok)
-{
-	switch (tok.m_type)
-	{
-		case TokenType::TT_PLUS:
-		case TokenType::TT_MINUS:
-		case TokenType::TT_MULT:
-		case TokenType::TT_DIV:
-		case TokenType::TT_MOD:
-			return true;
-
-		default:
-			return false;
-	}
-}
-
 size_t getPriority(const Token& tok)
 {
 	switch (tok.m_type)
@@ -149,9 +89,9 @@ size_t getPriority(const Token& tok)
 std::vector<Token> infixToPostfix(const std::vector<Token>& toks)
 {
 	std::vector<Token> _new;
-	_new.push_back(Token(toks[0].m_lineno, TokenType::TT_OPEN_PAREN, std::string('(', 1), 0, 0));
+	_new.push_back(Token(toks[0].m_lineno, TokenType::TT_OPEN_PAREN, "(", 0, 0));
 	_new.insert(_new.end(), toks.begin(), toks.end());
-	_new.push_back(Token(toks[toks.size() - 1].m_lineno, TokenType::TT_CLOSE_PAREN, std::string(')', 1), 0, 0));
+	_new.push_back(Token(toks[toks.size() - 1].m_lineno, TokenType::TT_CLOSE_PAREN, ")", 0, 0));
 
 	std::vector<Token> postfix;
 	std::stack<Token> stack;
@@ -200,379 +140,483 @@ std::vector<Token> infixToPostfix(const std::vector<Token>& toks)
 	return postfix;
 }
 
-std::string getVal(const Token& tok)
+IrOperand getVal(const Token& tok)
 {
 	switch (tok.m_type)
 	{
 		case TokenType::TT_NUM:
-		{
-			return tok.m_val;
-			break;
-		}
+			return irImm(tok.m_val);
 
 		case TokenType::TT_FLOAT:
-		{
-			return tok.m_val + "f32";
-			break;
-		}
+			return irFloat(tok.m_val);
 
 		default:
-			return "";
+			return irImm("");
 	}
 }
 
-std::string getOpName(const Token& tok)
+IrOp getIrOp(const Token& tok)
 {
 	switch (tok.m_type)
 	{
 		case TokenType::TT_PLUS:
-			return "ADD";
+			return IrOp::IR_ADD;
 
 		case TokenType::TT_MINUS:
-			return "SUB";
+			return IrOp::IR_SUB;
 
 		case TokenType::TT_MULT:
-			return "MLT";
+			return IrOp::IR_MLT;
 
 		case TokenType::TT_DIV:
-			return "DIV";
-		
-		case TokenType::TT_MOD:
-			return "MOD";
+			return IrOp::IR_DIV;
 
+		case TokenType::TT_MOD:
 		default:
-			return "";
+			return IrOp::IR_MOD;
+	}
+}
+
+IrCond getIrCond(const Token& tok)
+{
+	switch (tok.m_type)
+	{
+		case TokenType::TT_NEQ: return IrCond::IC_NE;
+		case TokenType::TT_GT:  return IrCond::IC_GT;
+		case TokenType::TT_GTE: return IrCond::IC_GE;
+		case TokenType::TT_LT:  return IrCond::IC_LT;
+		case TokenType::TT_LTE: return IrCond::IC_LE;
+		default:                return IrCond::IC_EQ;
 	}
 }
 
-VarStackFrame parseExpr(const std::vector<Token>& toks, const VarStack& locals, const VarStack& funcArgs)
+// Condition that holds exactly when cond does not
+IrCond invertCond(const IrCond& cond)
+{
+	switch (cond)
+	{
+		case IrCond::IC_EQ: return IrCond::IC_NE;
+		case IrCond::IC_NE: return IrCond::IC_EQ;
+		case IrCond::IC_GT: return IrCond::IC_LE;
+		case IrCond::IC_GE: return IrCond::IC_LT;
+		case IrCond::IC_LT: return IrCond::IC_GE;
+		default:            return IrCond::IC_GT;
+	}
+}
+
+// Reports an error and gives up on the statement it is in
+[[noreturn]] static void compileError(Diagnostics& diagnostics, const SourceFile& src, const std::string& message, const Token& tok)
+{
+	diagnostics.error(src, message, tok);
+	throw CompileError();
+}
+
+// Load of a variable into register reg, locals shadow arguments of the same name
+static std::optional<IrInstruction> loadVariable(std::string_view name, const size_t& reg, const SymbolTable& locals, const SymbolTable& funcArgs)
+{
+	if (const SymbolTable::Symbol* local = locals.find(name))
+		return IrInstruction { IrOp::IR_LOAD, getIrType(local->type), irReg(reg), irLocal(local->stackOffset) };
+
+	if (const SymbolTable::Symbol* funcArg = funcArgs.find(name))
+		return IrInstruction { IrOp::IR_LOAD, getIrType(funcArg->type), irReg(reg), irArg(funcArg->stackOffset) };
+
+	return std::nullopt;
+}
+
+VarStackFrame parseExpr(const SourceFile& src, Diagnostics& diagnostics, std::span<const Token> toks, const SymbolTable& locals, const SymbolTable& funcArgs)
 {
 	if (toks.size() == 1 && toks[0].m_type != TokenType::TT_IDENTIFIER)
-		return VarStackFrame{ toks[0].m_val, "" };
+		return VarStackFrame{ irImm(toks[0].m_val), {} };
 	else
 	{
 		if (toks.size() == 1)
 		{
-			size_t index = locals.getOffset(toks[0].m_val);
-			if (index == size_t(-1))
+			std::optional<IrInstruction> load = loadVariable(toks[0].m_val, 2, locals, funcArgs);
+			if (!load)
 			{
-				index = funcArgs.getOffset(toks[0].m_val);
-
-				if (index == size_t(-1))
-				{
-					std::cerr << "No such variable " << toks[0].m_val << " in current context at line " << toks[0].m_lineno << '\n';
-					std::cerr << toks[0].m_lineno << ": " << getSourceLine(glob_src, toks[0].m_lineno);
-					drawArrows(toks[0].m_start, toks[0].m_end, toks[0].m_lineno);
-					exit(-1);
-				}
-
-				return { "R2", "LLOD R2 R1 " + std::to_string(index + 1) + '\n' };
+				compileError(diagnostics, src, "No such variable " + std::string(toks[0].m_val) + " in current context", toks[0]);
 			}
-			else
-				return { "R2", "LLOD R2 R1 -" + std::to_string(index) + '\n' };
+
+			return { irReg(2), { *load } };
 		}
 
 		// Convert infix to prefix from toks vector
 
 		// Get prefix from infix using postfix
-		auto copy = toks;
+		std::vector<Token> copy(toks.begin(), toks.end());
 		size_t l = copy.size();
 		std::reverse(copy.begin(), copy.end());
 		for (size_t i = 0; i < l; ++i)
 			if (copy[i].m_type == TokenType::TT_OPEN_PAREN)
 			{
 				copy[i].m_type = TokenType::TT_CLOSE_PAREN;
-				copy[i].m_val = std::string(')', 1);
+				copy[i].m_val = ")";
 			}
 			else if (copy[i].m_type == TokenType::TT_CLOSE_PAREN)
 			{
 				copy[i].m_type = TokenType::TT_OPEN_PAREN;
-				copy[i].m_val = std::string('(', 1);
+				copy[i].m_val = "(";
 			}
 		std::vector<Token> prefix = infixToPostfix(copy);
 		std::reverse(prefix.begin(), prefix.end());
 
-		std::string code;
 		TokenBuffer buf(prefix);
-		std::queue<std::string> codeStack;
-		std::queue<std::string> varsQueue;
+		std::vector<IrInstruction> codeStack;
+		std::vector<IrInstruction> varsQueue;
 
 		// I HATE THAT I HAVE TO USE STD::FUNCTION
-		std::function<std::string(TokenBuffer&, size_t)> parseOp = [&codeStack, &varsQueue, &parseOp, &locals, &funcArgs](TokenBuffer& buf, size_t regIndex) -> std::string
+		std::function<IrInstruction(TokenBuffer&, size_t)> parseOp = [&codeStack, &varsQueue, &parseOp, &prefix, &toks, &src, &diagnostics, &locals, &funcArgs](TokenBuffer& buf, size_t regIndex) -> IrInstruction
 		{
-			std::string _return;
-
-			const Token& tok = buf.current();
-			_return += getOpName(tok) + ' ';
-			_return += "R" + std::to_string(regIndex) + ' ';
-
-			Token next = buf.next();
-			if (isOperator(next))
+			// Calls and other tokens that are not arithmetic leave the prefix form without an operator or its operands
+			if (!isOperator(buf.current()))
 			{
-				regIndex++;
-				codeStack.push(parseOp(buf, regIndex));
-				_return += "R" + std::to_string(regIndex) + ' ';
+				compileError(diagnostics, src, "Error: Invalid expression", toks[0]);
 			}
-			else if (next.m_type == TokenType::TT_IDENTIFIER)
-			{
-				regIndex++;
-				size_t offset = locals.getOffset(next.m_val);
 
-				if (offset == size_t(-1))
-				{
-					// Variable is not in locals, but maybe in function arguments
+			IrInstruction instruction { getIrOp(buf.current()), IR_WORD, irReg(regIndex) };
 
-					// If there are no function arguments then this identifier doesnt exist
-					if (funcArgs.getSize() == 0)
-					{
-						std::cerr << "Error: No such variable " << next.m_val << " in current context at line " << next.m_lineno << '\n';
-						std::cerr << next.m_lineno << ": " << getSourceLine(glob_src, next.m_lineno);
-						drawArrows(next.m_start, next.m_end, next.m_lineno);
-						exit(-1);
-					}
+			for (IrOperand* operand: { &instruction.a, &instruction.b })
+			{
+				if (buf.pos() + 1 >= prefix.size())
+				{
+					compileError(diagnostics, src, "Error: Invalid expression", toks[0]);
+				}
 
-					// Check for variable in function arguments
-					offset = funcArgs.getOffset(next.m_val);
-					if (offset == size_t(-1))
+				const Token& next = buf.next();
+				if (isOperator(next))
+				{
+					regIndex++;
+					codeStack.push_back(parseOp(buf, regIndex));
+					*operand = irReg(regIndex);
+				}
+				else if (next.m_type == TokenType::TT_IDENTIFIER)
+				{
+					regIndex++;
+					std::optional<IrInstruction> load = loadVariable(next.m_val, regIndex, locals, funcArgs);
+					if (!load)
 					{
-						std::cerr << "Error: No such variable " << next.m_val << " in current context at line " << next.m_lineno << '\n';
-						std::cerr << next.m_lineno << ": " << getSourceLine(glob_src, next.m_lineno);
-						drawArrows(next.m_start, next.m_end, next.m_lineno);
-						exit(-1);
+						compileError(diagnostics, src, "Error: No such variable " + std::string(next.m_val) + " in current context", next);
 					}
 
-					varsQueue.push("LLOD R" + std::to_string(regIndex) + " R1 " + std::to_string(offset + 1) + '\n');
-					_return += "R" + std::to_string(regIndex) + ' ';
+					varsQueue.push_back(*load);
+					*operand = irReg(regIndex);
 				}
 				else
-				{
-					varsQueue.push("LLOD R" + std::to_string(regIndex) + " R1 -" + std::to_string(offset) + '\n');
-					_return += "R" + std::to_string(regIndex) + ' ';
-				}
+					*operand = getVal(next);
 			}
-			else
-				_return += getVal(next) + ' ';
 
-			next = buf.next();
-			if (isOperator(next))
+			return instruction;
+		};
+
+		size_t startRegIndex = 2;
+		const IrInstruction top = parseOp(buf, startRegIndex);
+
+		VarStackFrame frame { irReg(2), std::move(varsQueue) };
+		frame.code.insert(frame.code.end(), codeStack.begin(), codeStack.end());
+		frame.code.push_back(top);
+		return frame;
+	}
+}
+
+// Source line as a comment for -g output, without its indentation
+IrInstruction debugSymbol(const SourceFile& src, const size_t& lineno)
+{
+	std::string_view line = src.getLine(lineno);
+	while (!line.empty() && isspace(line.front())) line.remove_prefix(1);
+	while (!line.empty() && isspace(line.back()))  line.remove_suffix(1);
+
+	return { IrOp::IR_COMMENT, {}, {}, irText(line) };
+}
+
+
+// Function bodies are generated concurrently, after the declaration pass has declared every function
+struct FunctionJob
+{
+	NodeIndex node;
+	size_t linkerIndex;
+
+	// Label numbers before the body and after it, nested functions included
+	LabelCounters start;
+	LabelCounters end;
+};
+
+// What the declaration pass works out in compile order, so that bodies generate
+// the same code as if they were compiled one after another, in any order
+struct Declarations
+{
+	std::vector<FunctionJob> jobs;
+	// Job of every function node
+	std::vector<size_t> jobOf;
+	// Number of linker functions declared before every call node, the ones it can call
+	std::vector<size_t> visibleAt;
+	// Label numbers after every import node, imported Hexagn libraries number their own labels
+	std::vector<LabelCounters> importEnd;
+};
+
+// State of the body being generated
+struct BodyContext
+{
+	CompilerContext& context;
+	const Linker& linker;
+	const Ast& ast;
+	const Declarations& decls;
+	const bool& debugSymbols;
+	// Errors of the body, bodies generated concurrently each get their own
+	Diagnostics& diagnostics;
+	// URCL printed from body
+	OutputBuffer& code;
+
+	LabelCounters labels;
+
+	// IR of the whole body, printed and dropped once it is lowered
+	IrBody body;
+
+	// Label and string numbers written into the code and the calls it makes, for the function cache
+	std::vector<Relocation> relocations;
+	std::vector<CachedCall> calls;
+};
+
+// Expression tokens of a node, views into the token vector the tree was parsed from
+static std::span<const Token> getExpr(const Ast& ast, const Node& node)
+{
+	return std::span<const Token>(ast.tokens.begin() + node.begin, ast.tokens.begin() + node.end);
+}
+
+// Scope declareScope is walking
+struct DeclareScope
+{
+	// Statement to declare next
+	NodeIndex next;
+	// Function the scope is the body of, NO_NODE for if and while bodies and the outermost scope
+	NodeIndex function;
+	// Label numbers before the body of function
+	LabelCounters start = {};
+};
+
+// Declares a function once its body has been walked
+static void declareFunction(CompilerContext& context, Linker& linker, const Ast& ast, Declarations& decls, const DeclareScope& scope)
+{
+	const Node& node = ast[scope.function];
+	FunctionJob job { scope.function, 0, scope.start, context.labels };
+
+	Function func { ast.tokens[node.name], ast.tokens[node.token] };
+	for (NodeIndex param = node.list; param != NO_NODE; param = ast[param].next)
+		func.argTypes.push_back(ast.tokens[ast[param].token]);
+
+	job.linkerIndex = linker.addFunction(func);
+
+	decls.jobOf[scope.function] = decls.jobs.size();
+	decls.jobs.push_back(job);
+}
+
+// Declares functions, runs imports, numbers labels and registers string literals
+// in the order compileScope used to meet them when bodies were compiled in place
+static void declareScope(CompilerContext& context, Linker& linker, const Ast& ast, Declarations& decls, NodeIndex first)
+{
+	// Bodies are walked on an explicit stack rather than by recursion, so deep nesting cannot exhaust the stack
+	std::vector<DeclareScope> scopes { { first, NO_NODE } };
+	while (!scopes.empty())
+	{
+		DeclareScope& scope = scopes.back();
+		if (scope.next == NO_NODE)
+		{
+			if (scope.function != NO_NODE)
+				declareFunction(context, linker, ast, decls, scope);
+			scopes.pop_back();
+			continue;
+		}
+
+		const NodeIndex index = scope.next;
+		const Node& node = ast[index];
+		scope.next = node.next;
+
+		switch (node.type)
+		{
+			case NodeType::NT_VAR_DEFINITION:
 			{
-				regIndex++;
-				codeStack.push(parseOp(buf, regIndex));
-				_return += "R" + std::to_string(regIndex) + '\n';
+				if (ast.tokens[node.token].m_type == TokenType::TT_STRING && ast.tokens[node.begin].m_type == TokenType::TT_STR)
+					context.strings.registerString(ast.tokens[node.begin].m_val);
+				break;
 			}
-			else if (next.m_type == TokenType::TT_IDENTIFIER)
-			{
-				regIndex++;
-				size_t offset = locals.getOffset(next.m_val);
 
-				if (offset == size_t(-1))
-				{
-					// Variable is not in locals, but maybe in function arguments
+			case NodeType::NT_FUNCTION:
+			{
+				// Functions are declared after their body, so they cannot see themselves
+				scopes.push_back( { node.body, index, context.labels } );
+				break;
+			}
 
-					// If there are no function arguments then this identifier doesnt exist
-					if (funcArgs.getSize() == 0)
-					{
-						std::cerr << "Error: No such variable " << next.m_val << " in current context at line " << next.m_lineno << '\n';
-						std::cerr << next.m_lineno << ": " << getSourceLine(glob_src, next.m_lineno);
-						drawArrows(next.m_start, next.m_end, next.m_lineno);
-						exit(-1);
-					}
+			case NodeType::NT_CALL:
+			{
+				decls.visibleAt[index] = linker.getFunctions().size();
 
-					offset = funcArgs.getOffset(next.m_val);
-					if (offset == size_t(-1))
-					{
-						std::cerr << "Error: No such variable " << next.m_val << " in current context at line " << next.m_lineno << '\n';
-						std::cerr << next.m_lineno << ": " << getSourceLine(glob_src, next.m_lineno);
-						drawArrows(next.m_start, next.m_end, next.m_lineno);
-						exit(-1);
-					}
+				// Arguments are pushed in reverse order, which is the order their strings are registered in
+				std::vector<NodeIndex> args;
+				for (NodeIndex arg = node.list; arg != NO_NODE; arg = ast[arg].next)
+					args.push_back(arg);
 
-					varsQueue.push("LLOD R" + std::to_string(regIndex) + " R1 " + std::to_string(offset + 1) + '\n');
-					_return += "R" + std::to_string(regIndex) + '\n';
-				}
-				else
+				for (size_t i = args.size(); i-- > 0;)
 				{
-					varsQueue.push("LLOD R" + std::to_string(regIndex) + " R1 -" + std::to_string(offset) + '\n');
-					_return += "R" + std::to_string(regIndex) + '\n';
+					const Token& arg = ast.tokens[ast[args[i]].token];
+					if (arg.m_type == TokenType::TT_STR)
+						context.strings.registerString(arg.m_val);
 				}
+				break;
 			}
-			else
-				_return += getVal(next) + '\n';
 
-			return _return;
-		};
+			case NodeType::NT_IF:
+			{
+				context.labels.ifCount++;
+				scopes.push_back( { node.body, NO_NODE } );
+				break;
+			}
 
-		size_t startRegIndex = 2;
-		std::string code2 = parseOp(buf, startRegIndex);
+			case NodeType::NT_WHILE:
+			{
+				context.labels.whileCount++;
+				scopes.push_back( { node.body, NO_NODE } );
+				break;
+			}
 
-		while (!varsQueue.empty())
-		{
-			code += varsQueue.front();
-			varsQueue.pop();
-		}
-		while (!codeStack.empty())
-		{
-			code += codeStack.front();
-			codeStack.pop();
-		}
+			case NodeType::NT_IMPORT:
+			{
+				std::string libName;
+				for (TokenIndex i = node.begin; i < node.end; ++i)
+					libName += ast.tokens[i].m_val;
+
+				importLibrary(context, linker, libName);
+				decls.importEnd[index] = context.labels;
+				break;
+			}
 
-		code += code2;
-		return { "R2", code };
+			default: break;
+		}
 	}
 }
 
-inline const bool isDataType(const Token& tok)
+// Loads a number or local of an if or while condition into the next register
+static void loadCondition(IrBody& body, const Token& tok, const SymbolTable& locals, size_t& destCounter)
 {
-	return tok.m_type == TokenType::TT_VOID
-			|| tok.m_type == TokenType::TT_INT
-			|| tok.m_type == TokenType::TT_UINT
-			|| tok.m_type == TokenType::TT_FLOAT
-			|| tok.m_type == TokenType::TT_STRING
-			|| tok.m_type == TokenType::TT_CHARACTER;
+	if (tok.m_type == TokenType::TT_IDENTIFIER)
+		body.append( { IrOp::IR_LOAD, getIrType(locals.getType(tok.m_val)), irReg(destCounter++), irLocal(locals.getOffset(tok.m_val)) } );
+	else if (tok.m_type == TokenType::TT_NUM)
+		body.append( { IrOp::IR_IMM, IR_WORD, irReg(destCounter++), irImm(tok.m_val) } );
 }
 
-inline const bool isComparison(const Token& tok)
+// Prints the lowered body and drops its IR
+static void printBody(BodyContext& ctx)
 {
-	return tok.m_type == TokenType::TT_EQ
-			|| tok.m_type == TokenType::TT_NEQ
-			|| tok.m_type == TokenType::TT_GT
-			|| tok.m_type == TokenType::TT_GTE
-			|| tok.m_type == TokenType::TT_LT
-			|| tok.m_type == TokenType::TT_LTE;
+	printIr(ctx.body, ctx.code, ctx.relocations);
+	ctx.body.clear();
 }
 
-// Global variable to keep track of if statements
-size_t ifCount = 0;
-// Global variable to keep track of while statements
-size_t whileCount = 0;
+// Scope compileScope is generating the statements of
+struct OpenScope
+{
+	// Statement to generate next
+	NodeIndex next;
+	// If or while statement the scope is the body of, NO_NODE for the outermost scope
+	NodeIndex owner;
+	// Label number of owner
+	size_t label;
+	bool popFrame;
+};
 
-const std::string compile(Linker& linker, const std::vector<Token>& tokens, const bool& debugSymbols, const bool& emitFunctions, const bool& emitEntryPoint, const bool& isSubScope, const bool& popFrame, const VarStack& _locals, const VarStack& funcArgs)
+// Frees the variables of a scope that has ended and generates what follows the body of its owner
+static void closeScope(BodyContext& ctx, const OpenScope& scope, SymbolTable& locals)
 {
-	TokenBuffer buf(tokens);
-	std::stringstream code;
-	VarStack locals = _locals;
-	locals.startFrame();
+	IrBody& body = ctx.body;
 
-	if (emitEntryPoint)
+	const size_t frameSize = locals.popScope();
+	if (scope.popFrame)
+		body.append( { IrOp::IR_FREE, {}, {}, irCount(frameSize) } );
+
+	if (scope.owner == NO_NODE)
+		return;
+
+	if (ctx.ast[scope.owner].type == NodeType::NT_WHILE)
 	{
-		code << "BITS == 32\n";
-		code << "MINHEAP 4096\n";
-		code << "MINSTACK 1024\n";
-		code << "MOV R1 SP\n\n";
+		body.append( { IrOp::IR_JMP, {}, irLabel(IrLabelKind::IL_WHILE, scope.label) } );
+		body.addLabel(irLabel(IrLabelKind::IL_ENDWHILE, scope.label));
 	}
-	
-	while (buf.hasNext())
+	else
+		body.addLabel(irLabel(IrLabelKind::IL_ENDIF, scope.label));
+}
+
+static void compileScope(BodyContext& ctx, NodeIndex first, const bool& popFrame, SymbolTable& locals, const SymbolTable& funcArgs)
+{
+	IrBody& body = ctx.body;
+	const Ast& ast = ctx.ast;
+	const SourceFile& src = ctx.context.src;
+	const bool& debugSymbols = ctx.debugSymbols;
+	Diagnostics& diagnostics = ctx.diagnostics;
+
+	// Bodies of if and while statements are walked on an explicit stack rather than by recursion,
+	// so deep nesting cannot exhaust the stack, which is small on the threads bodies are compiled on
+	std::vector<OpenScope> scopes { { first, NO_NODE, 0, popFrame } };
+	locals.pushScope();
+
+	while (!scopes.empty())
 	{
-		const Token& current = buf.current();
-		switch (current.m_type)
+		OpenScope& scope = scopes.back();
+		if (scope.next == NO_NODE)
 		{
-			// Variable or function definition
-			case TokenType::TT_VOID:
-			case TokenType::TT_INT:
-			case TokenType::TT_UINT:
-			case TokenType::TT_FLOAT:
-			case TokenType::TT_STRING:
-			case TokenType::TT_CHARACTER:
-			{
-				if (debugSymbols)
-					code << "// " << getSourceLine(glob_src, current.m_lineno);
-
-				buf.advance();
-				if (!buf.hasNext())
-				{
-					std::cerr << "Error: Expected identifier after keyword at line " << current.m_lineno << '\n';
-					std::cerr << current.m_lineno << ": " << getSourceLine(glob_src, current.m_lineno);
-					drawArrows(current.m_start, current.m_end, current.m_lineno);
-					exit(-1);
-				}
-				Token next = buf.current();
-				const Token& identifier = buf.current();
+			closeScope(ctx, scope, locals);
+			scopes.pop_back();
+			continue;
+		}
 
-				buf.advance();
-				if (!buf.hasNext() || (buf.current().m_type != TokenType::TT_ASSIGN && buf.current().m_type != TokenType::TT_OPEN_PAREN && buf.current().m_type != TokenType::TT_SEMICOLON))
-				{
-					std::cerr << "Error: Expected '=' or ';' or '(' at line " << next.m_lineno << '\n';
-					std::cerr << next.m_lineno << ": " << getSourceLine(glob_src, next.m_lineno);
-					drawArrows(next.m_start, next.m_end, next.m_lineno);
-					exit(-1);
-				}
-				next = buf.current();
+		const NodeIndex index = scope.next;
+		const Node& node = ast[index];
+		const Token& current = ast.tokens[node.token];
+		scope.next = node.next;
 
-				// Variable definition
-				if (next.m_type == TokenType::TT_ASSIGN)
+		// A statement with an error is dropped, the ones after it are still checked
+		try
+		{
+			switch (node.type)
+			{
+				case NodeType::NT_VAR_DEFINITION:
 				{
-					if (current.m_type == TokenType::TT_VOID)
-					{
-						std::cerr << "Error: Cannot have void type for variable at line " + current.m_lineno << '\n';
-						std::cerr << current.m_lineno << ": " << getSourceLine(glob_src, current.m_lineno);
-						drawArrows(current.m_start, current.m_end, current.m_lineno);
-						exit(-1);
-					}
+					if (debugSymbols)
+						body.append(debugSymbol(src, current.m_lineno));
 
-					buf.advance();
-					if (!buf.hasNext())
-					{
-						std::cerr << "Error: Expected expression after '=' at line " << next.m_lineno << '\n';
-						std::cerr << next.m_lineno << ": " << getSourceLine(glob_src, next.m_lineno);
-						drawArrows(next.m_start, next.m_end, next.m_lineno);
-						exit(-1);
-					}
+					const Token& identifier = ast.tokens[node.name];
+					const std::span<const Token> expr = getExpr(ast, node);
+					const IrType type = getIrType(current);
 
-					std::vector<Token> expr;
-					while (buf.hasNext() && buf.current().m_type != TokenType::TT_SEMICOLON)
-					{
-						const Token& curr = buf.current();
-
-						if (!isNumber(curr) && !isOperator(curr) && curr.m_type != TokenType::TT_IDENTIFIER && curr.m_type != TokenType::TT_OPEN_PAREN && curr.m_type != TokenType::TT_CLOSE_PAREN && curr.m_type != TokenType::TT_STR)
-						{
-							std::cerr << "Error: Expression cannot have non-number or non-operator or non-identifer or non-parenthesis tokens at line " << curr.m_lineno << '\n';
-							std::cerr << curr.m_lineno << ": " << getSourceLine(glob_src, curr.m_lineno);
-							drawArrows(curr.m_start, curr.m_end, curr.m_lineno);
-							exit(-1);
-						}
-
-						expr.push_back(curr);
-						buf.advance();
-					}
-
-					auto [val, _code] = parseExpr(expr, locals, funcArgs);
-					code << _code;
+					auto [val, _code] = parseExpr(src, diagnostics, expr, locals, funcArgs);
+					body.append(_code);
 
 					if (isIntegerDataType(current))
 					{
-						// Get the number in string current.m_val
+						// Get the width of the type
 						// For example: int32 -> 32
-						uintmax_t size = 0;
-						for (const char& c: current.m_val)
-							if (isdigit(c))
-								size = (size * 10) + (c - '0');
+						uintmax_t size = findKeyword(current.m_val)->width;
 						size = std::pow(2, size);
 						size--;
-						
+
 						std::stringstream sizeStream;
 						sizeStream << "0x" << std::hex << size;
 
-						code << "AND R2 " << val << ' ' << sizeStream.str() << '\n';
-						code << "PSH R2\n\n";
+						body.append( { IrOp::IR_AND, type, irReg(2), val, irImm(body.addText(sizeStream.str())) } );
+						body.append( { IrOp::IR_PUSH, type, {}, irReg(2) } );
+						body.endStatement();
 					}
 
 					else if (current.m_type == TokenType::TT_STRING)
 					{
 						if (expr[0].m_type != TokenType::TT_STR)
 						{
-							std::cerr << "Error: Expected string literal at line " << expr[0].m_lineno << '\n';
-							std::cerr << expr[0].m_lineno << ": " << getSourceLine(glob_src, expr[0].m_lineno);
-							drawArrows(expr[0].m_start, expr[0].m_end, expr[0].m_lineno);
-							exit(-1);
+							compileError(diagnostics, src, "Error: Expected string literal", expr[0]);
 						}
 
-						const std::string& string = expr[0].m_val;
-
-						// Register the string into the string table and get the signature
-						const std::string& signature = registerString(string);
+						const std::string_view string = expr[0].m_val;
 
-						// Put definition to stacc
-						code << "MOV R2 " << signature << "\nPSH R2\n\n";
+						// Register the string into the string table and put its label to stacc
+						body.append( { IrOp::IR_MOV, type, irReg(2), irString(ctx.context.strings.registerString(string), string) } );
+						body.append( { IrOp::IR_PUSH, type, {}, irReg(2) } );
+						body.endStatement();
 					}
 
 					else if (current.m_type == TokenType::TT_CHARACTER)
@@ -580,713 +624,492 @@ const std::string compile(Linker& linker, const std::vector<Token>& tokens, cons
 						const Token& tok = expr[0];
 
 						if (tok.m_type == TokenType::TT_CHAR)
-							code << "IMM R2 " << (int) expr[0].m_val[0] << '\n';
+							body.append( { IrOp::IR_IMM, type, irReg(2), irImm(body.addText(std::to_string((int) expr[0].m_val[0]))) } );
 						else if (tok.m_type == TokenType::TT_NUM)
-							code << "MOD R2 " << tok.m_val << " 0xff\n";
+							body.append( { IrOp::IR_MOD, type, irReg(2), irImm(tok.m_val), irImm("0xff") } );
 						else
 						{
-							std::cerr << "Error: Expected character literal or number at line " << expr[0].m_lineno << '\n';
-							std::cerr << expr[0].m_lineno << ": " << getSourceLine(glob_src, expr[0].m_lineno);
-							drawArrows(expr[0].m_start, expr[0].m_end, expr[0].m_lineno);
-							exit(-1);
+							compileError(diagnostics, src, "Error: Expected character literal or number", expr[0]);
 						}
 
-						code << "PSH R2\n\n";
+						body.append( { IrOp::IR_PUSH, type, {}, irReg(2) } );
+						body.endStatement();
 					}
 
 					locals.push(identifier.m_val, current);
+					break;
 				}
 
-				// Variable declaration
-				else if (next.m_type == TokenType::TT_SEMICOLON)
-				{
-					locals.push(identifier.m_val, current);
-					code << "DEC SP SP";
-				}
-
-				// Function definition
-				else if (next.m_type == TokenType::TT_OPEN_PAREN)
+				case NodeType::NT_VAR_DECLARATION:
 				{
-					if (isSubScope)
-					{
-						std::cerr << "Error: Nested functions are not supported at line " << current.m_lineno << '\n';
-						std::cerr << current.m_lineno << ": " << getSourceLine(glob_src, current.m_lineno);
-						drawArrows(current.m_start, current.m_end, current.m_lineno);
-						exit(-1);
-					}
-
-					Function func { identifier, current };
-
-					buf.advance();
-					if (!buf.hasNext() || !(isDataType(buf.current()) || buf.current().m_type == TokenType::TT_CLOSE_PAREN))
-					{
-						std::cerr << "Error: Expected keyword or ')' at line " << next.m_lineno << '\n';
-						std::cerr << next.m_lineno << ": " << getSourceLine(glob_src, next.m_lineno);
-						drawArrows(next.m_start, next.m_end, next.m_lineno);
-						exit(-1);
-					}
-					next = buf.current();
-
-					// Append parameters in loop
-					VarStack funcArgsStack;
-					while (buf.hasNext() && buf.current().m_type != TokenType::TT_CLOSE_PAREN)
-					{
-						const Token& type = buf.current();
-						if (!buf.hasNext() || !isDataType(type))
-						{
-							std::cerr << "Error: Expected keyword or ')' at line " << type.m_lineno << '\n';
-							std::cerr << type.m_lineno << ": " << getSourceLine(glob_src, type.m_lineno);
-							drawArrows(type.m_start, type.m_end, type.m_lineno);
-							exit(-1);
-						}
+					if (debugSymbols)
+						body.append(debugSymbol(src, current.m_lineno));
 
-						buf.advance();
-						if (!buf.hasNext() || buf.current().m_type != TokenType::TT_IDENTIFIER)
-						{
-							std::cerr << "Error: Expected identifier after keyword at line " << next.m_lineno << '\n';
-							std::cerr << next.m_lineno << ": " << getSourceLine(glob_src, next.m_lineno);
-							drawArrows(next.m_start, next.m_end, next.m_lineno);
-							exit(-1);
-						}
-						next = buf.current();
-						const Token& identifier = buf.current();
-
-						func.argTypes.push_back(type);
-						funcArgsStack.push(identifier.m_val, type);
-
-						buf.advance();
-						if (!buf.hasNext())
-						{
-							std::cerr << "Error: Expected ',' or ')' at line " << next.m_lineno << '\n';
-							std::cerr << next.m_lineno << ": " << getSourceLine(glob_src, next.m_lineno);
-							drawArrows(next.m_start, next.m_end, next.m_lineno);
-							exit(-1);
-						}
-						next = buf.current();
-						
-						if (next.m_type == TokenType::TT_CLOSE_PAREN)
-							break;
-						else if (next.m_type != TokenType::TT_COMMA)
-						{
-							std::cerr << "Error: Expected ',' or ')' at line " << next.m_lineno << '\n';
-							std::cerr << next.m_lineno << ": " << getSourceLine(glob_src, next.m_lineno);
-							drawArrows(next.m_start, next.m_end, next.m_lineno);
-							exit(-1);
-						}
-
-						buf.advance();
-					}
-
-					buf.advance();
-					// Parse function body
-					if (!buf.hasNext() || buf.current().m_type != TokenType::TT_OPEN_BRACE)
-					{
-						std::cerr << "Error: Expected '{' at line " << next.m_lineno << '\n';
-						std::cerr << next.m_lineno << ": " << getSourceLine(glob_src, next.m_lineno);
-						drawArrows(next.m_start, next.m_end, next.m_lineno);
-						exit(-1);
-					}
-					next = buf.current();
-
-					buf.advance();
-					if (!buf.hasNext())
-					{
-						std::cerr << "Error: Expected function body or '}' at line " << next.m_lineno << '\n';
-						std::cerr << next.m_lineno << ": " << getSourceLine(glob_src, next.m_lineno);
-						drawArrows(next.m_start, next.m_end, next.m_lineno);
-						exit(-1);
-					}
-
-					// Get function body in loop
-					std::vector<Token> body;
-					size_t scope = 0;
-					while (buf.hasNext())
-					{
-						if (buf.current().m_type == TokenType::TT_OPEN_BRACE)
-							++scope;
-						else if (buf.current().m_type == TokenType::TT_CLOSE_BRACE)
-						{
-							if (scope == 0)
-								break;
-							--scope;
-						}
-
-						body.push_back(buf.current());
-						buf.advance();
-					}
-
-					func.code = compile(linker, body, debugSymbols, false, false, false, true, VarStack(), funcArgsStack);
-					linker.addFunction(func);
+					locals.push(ast.tokens[node.name].m_val, current);
+					body.append( { IrOp::IR_ALLOC, getIrType(current) } );
+					break;
 				}
 
-				break;
-			}
-
-			// Variable reassignment or function call
-			case TokenType::TT_IDENTIFIER:
-			{
-				if (debugSymbols)
-					code << "// " << getSourceLine(glob_src, current.m_lineno);
-
-				const Token& identifier = buf.current();
-				size_t offset = locals.getOffset(identifier.m_val);
-				bool isInArgs = false;
-
-				buf.advance();
-				if (!buf.hasNext() && !(buf.current().m_type == TokenType::TT_ASSIGN || buf.current().m_type == TokenType::TT_OPEN_PAREN))
+				case NodeType::NT_FUNCTION:
 				{
-					std::cerr << "Error: Expected '=' or function call after identifier at line " << current.m_lineno << '\n';
-					std::cerr << current.m_lineno << ": " << getSourceLine(glob_src,current.m_lineno);
-					drawArrows(current.m_start, current.m_end, current.m_lineno);
-					exit(-1);
+					if (debugSymbols)
+						body.append(debugSymbol(src, current.m_lineno));
+
+					// The body is generated by its own job, its labels are skipped here
+					ctx.labels = ctx.decls.jobs[ctx.decls.jobOf[index]].end;
+					break;
 				}
-				Token next = buf.current();
 
 				// Variable reassignment
-				if (next.m_type == TokenType::TT_ASSIGN)
+				case NodeType::NT_ASSIGNMENT:
 				{
-					if (offset == size_t(-1))
-					{
-						offset = funcArgs.getOffset(identifier.m_val);
-						isInArgs = true;
+					if (debugSymbols)
+						body.append(debugSymbol(src, current.m_lineno));
 
-						if (offset == size_t(-1))
-						{
-							std::cerr << "Error: No such variable '" << identifier.m_val << "' in current context at line " << identifier.m_lineno << '\n';
-							std::cerr << identifier.m_lineno << ": " << getSourceLine(glob_src, identifier.m_lineno);
-							drawArrows(identifier.m_start, identifier.m_end, identifier.m_lineno);
-							exit(-1);
-						}
+					const Token& identifier = current;
+					IrOperand slot;
+					IrType type;
 
-						offset++;
+					if (const SymbolTable::Symbol* local = locals.find(identifier.m_val))
+					{
+						slot = irLocal(local->stackOffset);
+						type = getIrType(local->type);
 					}
-
-					buf.advance();
-					if (!buf.hasNext())
+					else if (const SymbolTable::Symbol* funcArg = funcArgs.find(identifier.m_val))
 					{
-						std::cerr << "Error: Expected expression after '=' at line " << next.m_lineno << '\n';
-						std::cerr << next.m_lineno << ": " << getSourceLine(glob_src, next.m_lineno);
-						drawArrows(next.m_start, next.m_end, next.m_lineno);
-						exit(-1);
+						slot = irArg(funcArg->stackOffset);
+						type = getIrType(funcArg->type);
 					}
-
-					std::vector<Token> expr;
-					while (buf.hasNext() && buf.current().m_type != TokenType::TT_SEMICOLON)
+					else
 					{
-						const Token& curr = buf.current();
-
-						if (!isNumber(curr) && !isOperator(curr) && curr.m_type != TokenType::TT_IDENTIFIER && curr.m_type != TokenType::TT_OPEN_PAREN && curr.m_type != TokenType::TT_CLOSE_PAREN)
-						{
-							std::cerr << "Error: Expression cannot have non-number or non-operator or non-identifer or non-parenthesis tokens at line " << curr.m_lineno << '\n';
-							std::cerr << curr.m_lineno << ": " << getSourceLine(glob_src, curr.m_lineno);
-							drawArrows(curr.m_start, curr.m_end, curr.m_lineno);
-							exit(-1);
-						}
-
-						expr.push_back(curr);
-						buf.advance();
+						compileError(diagnostics, src, "Error: No such variable '" + std::string(identifier.m_val) + "' in current context", identifier);
 					}
 
-					auto [val, _code] = parseExpr(expr, locals, funcArgs);
-					code << _code;
+					auto [val, _code] = parseExpr(src, diagnostics, getExpr(ast, node), locals, funcArgs);
+					body.append(_code);
 
-					if (!isInArgs)
-						code << "LSTR R1 -" << offset << ' ' << val << "\n\n";
-					else
-						code << "LSTR R1 " << offset << ' ' << val << "\n\n";
+					body.append( { IrOp::IR_STORE, type, {}, slot, val } );
+					body.endStatement();
+					break;
 				}
 
 				// Function call
-				else if (next.m_type == TokenType::TT_OPEN_PAREN)
+				case NodeType::NT_CALL:
 				{
-					buf.advance();
-					if (!buf.hasNext())
-					{
-						std::cerr << "Error: Expected identifier or ')' at line " << next.m_lineno << '\n';
-						std::cerr << next.m_lineno << ": " << getSourceLine(glob_src, next.m_lineno);
-						drawArrows(next.m_start, next.m_end, next.m_lineno);
-						exit(-1);
-					}
+					if (debugSymbols)
+						body.append(debugSymbol(src, current.m_lineno));
 
-					// Append function arguments in loop
 					std::vector<Token> args;
 					std::vector<Token> argTypes;
-					while (buf.hasNext() && buf.current().m_type != TokenType::TT_CLOSE_PAREN)
+					// Stack loads of identifier arguments, resolved once here
+					std::vector<std::optional<IrInstruction>> argLoads;
+					for (NodeIndex arg = node.list; arg != NO_NODE; arg = ast[arg].next)
 					{
-						const Token& val = buf.current();
-						if (!buf.hasNext() || (val.m_type != TokenType::TT_IDENTIFIER && val.m_type != TokenType::TT_NUM && val.m_type != TokenType::TT_STR))
-						{
-							std::cerr << "Error: Expected identifier or value at line " << buf.current().m_lineno << '\n';
-							std::cerr << buf.current().m_lineno << ": " << getSourceLine(glob_src, buf.current().m_lineno);
-							drawArrows(buf.current().m_start, buf.current().m_end, buf.current().m_lineno);
-							exit(-1);
-						}
-
-						if (val.m_type == TokenType::TT_IDENTIFIER && locals.getOffset(val.m_val) == size_t(-1) && funcArgs.getOffset(val.m_val) == size_t(-1))
-						{
-							std::cerr << "Error: No such variable '" << val.m_val << "' in current context at line " << val.m_lineno << '\n';
-							std::cerr << val.m_lineno << ": " << getSourceLine(glob_src, val.m_lineno);
-							drawArrows(val.m_start, val.m_end, val.m_lineno);
-							exit(-1);
-						}
+						const Token& val = ast.tokens[ast[arg].token];
 
 						args.push_back(val);
+						argLoads.emplace_back();
 						if (val.m_type == TokenType::TT_STR)
 							argTypes.push_back(Token(val.m_lineno, TokenType::TT_STRING, val.m_val, val.m_start, val.m_end));
 						else if (val.m_type == TokenType::TT_NUM)
 							argTypes.push_back(val);
 						else
 						{
-							Token type = locals.getType(val.m_val);
-							if (type.m_type == (TokenType) -1)
-								type = funcArgs.getType(val.m_val);
-							argTypes.push_back(type);
-						}
-
-						buf.advance();
-
-						if (buf.current().m_type == TokenType::TT_CLOSE_PAREN)
-							break;
+							if (const SymbolTable::Symbol* local = locals.find(val.m_val))
+								argTypes.push_back(local->type);
+							else if (const SymbolTable::Symbol* funcArg = funcArgs.find(val.m_val))
+								argTypes.push_back(funcArg->type);
+							else
+							{
+								compileError(diagnostics, src, "Error: No such variable '" + std::string(val.m_val) + "' in current context", val);
+							}
 
-						if (!buf.hasNext() || buf.current().m_type != TokenType::TT_COMMA)
-						{
-							std::cerr << "Error: Expected ',' or ')' at line " << buf.current().m_lineno << '\n';
-							std::cerr << buf.current().m_lineno << ": " << getSourceLine(glob_src, buf.current().m_lineno);
-							drawArrows(buf.current().m_start, buf.current().m_end, buf.current().m_lineno);
-							exit(-1);
+							argLoads.back() = loadVariable(val.m_val, 2, locals, funcArgs);
 						}
-
-						buf.advance();
 					}
 
 					// Push arguments in reverse order
-					for (const auto& arg: args | std::views::reverse)
+					for (size_t i = args.size(); i-- > 0;)
 					{
-						std::string val;
-						if (arg.m_type == TokenType::TT_IDENTIFIER)
+						const Token& arg = args[i];
+						const IrType type = getIrType(argTypes[i]);
+
+						if (arg.m_type == TokenType::TT_STR)
 						{
-							if (locals.getOffset(arg.m_val) != size_t(-1))
-								code << "LLOD R2 R1 -" + std::to_string(locals.getOffset(arg.m_val)) << '\n';
-							else if (funcArgs.getOffset(arg.m_val) != size_t(-1))
-								code << "LLOD R2 R1 " + std::to_string(funcArgs.getOffset(arg.m_val) + 1) << '\n';
-							else
-							{
-								std::cerr << "Error: No such variable '" << arg.m_val << "' in current context at line " << arg.m_lineno << '\n';
-								std::cerr << arg.m_lineno << ": " << getSourceLine(glob_src, arg.m_lineno);
-								drawArrows(arg.m_start, arg.m_end, arg.m_lineno);
-								exit(-1);
-							}
+							body.append( { IrOp::IR_PUSH, type, {}, irString(ctx.context.strings.registerString(arg.m_val), arg.m_val) } );
+							continue;
+						}
 
-							val = "R2";
+						IrOperand val = irImm("");
+						if (arg.m_type == TokenType::TT_IDENTIFIER)
+						{
+							body.append(*argLoads[i]);
+							val = irReg(2);
 						}
-						else if (arg.m_type == TokenType::TT_STR)
-							val = registerString(arg.m_val);
 						else if (arg.m_type == TokenType::TT_NUM)
-							val = arg.m_val;
-						
-						code << "PSH " << val << '\n';
+							val = irImm(arg.m_val);
+
+						body.append( { IrOp::IR_PUSH, type, {}, val } );
 					}
 
-					const Function& func = linker.getFunction(glob_src, current, argTypes);
+					const Function& func = ctx.linker.getFunction(diagnostics, src, current, argTypes, ctx.decls.visibleAt[index]);
+
+					CachedCall call { std::string(current.m_val), {}, func.getSignature() };
+					for (const Token& type: argTypes)
+						call.argTypes.push_back(type.m_type);
+					ctx.calls.push_back(std::move(call));
 
-					code << "CAL ." << func.getSignature() << '\n';
+					body.append( { IrOp::IR_CALL, getIrType(func.returnType), {}, irFunction(func.getSignature()) } );
 
 					// Stack cleanup
-					code << "ADD SP SP " << args.size() << "\n\n";
+					body.append( { IrOp::IR_FREE, {}, {}, irCount(args.size()) } );
+					body.endStatement();
+					break;
 				}
 
-				break;
-			}
+				case NodeType::NT_IF:
+				{
+					if (debugSymbols)
+						body.append(debugSymbol(src, current.m_lineno));
 
-			case TokenType::TT_IF:
-			{
-				if (debugSymbols)
-					code << "// " << getSourceLine(glob_src, current.m_lineno);
+					ctx.labels.ifCount++;
+					// Save the current ifCount since it may be modified
+					size_t currIfCount = ctx.labels.ifCount;
 
-				ifCount++;
-				// Save the current ifCount since it may be modified
-				size_t currIfCount = ifCount;
+					size_t destCounter = 2;
+					loadCondition(body, ast.tokens[node.lhs], locals, destCounter);
+					loadCondition(body, ast.tokens[node.rhs], locals, destCounter);
 
-				int destCounter = 2;
+					const IrCond cond = getIrCond(ast.tokens[node.name]);
+					body.append( { IrOp::IR_BRANCH, {}, irLabel(IrLabelKind::IL_IF, currIfCount), irReg(destCounter - 2), irReg(destCounter - 1), cond } );
+					body.append( { IrOp::IR_JMP, {}, irLabel(IrLabelKind::IL_ENDIF, currIfCount) } );
 
-				buf.advance();
-				if (!buf.hasNext() || buf.current().m_type != TokenType::TT_OPEN_PAREN)
-				{
-					std::cerr << "Error: Expected '(' after if at line " << current.m_lineno << '\n';
-					std::cerr << current.m_lineno << ": " << getSourceLine(glob_src, current.m_lineno);
-					drawArrows(current.m_start, current.m_end, current.m_lineno);
-					exit(-1);
+					body.addLabel(irLabel(IrLabelKind::IL_IF, currIfCount));
+					locals.pushScope();
+					scopes.push_back( { node.body, index, currIfCount, true } );
+					break;
 				}
-				Token next = buf.current();
-				
-				buf.advance();
-				if (!buf.hasNext() || !(isNumber(buf.current()) || buf.current().m_type == TokenType::TT_IDENTIFIER))
-				{
-					std::cerr << "Error: Expected number or identifier after ( at line " << next.m_lineno << '\n';
-					std::cerr << next.m_lineno << ": " << getSourceLine(glob_src, next.m_lineno);
-					drawArrows(next.m_start, next.m_end, next.m_lineno);
-					exit(-1);
-				}
-				next = buf.current();
-
-				if (next.m_type == TokenType::TT_IDENTIFIER)
-					code << "LLOD R" << destCounter++ << " R1 " << "-" << locals.getOffset(buf.current().m_val) << '\n';
-				else if (next.m_type == TokenType::TT_NUM)
-					code << "IMM R" << destCounter++ << " " << buf.current().m_val << '\n';\
 
-				buf.advance();
-				if (!buf.hasNext() || !isComparison(buf.current()))
+				case NodeType::NT_WHILE:
 				{
-					std::cerr << "Error: Expected comparison operator after identifier/number at line " << next.m_lineno << '\n';
-					std::cerr << next.m_lineno << ": " << getSourceLine(glob_src, next.m_lineno);
-					drawArrows(next.m_start, next.m_end, next.m_lineno);
-					exit(-1);
-				}
-				next = buf.current();
+					if (debugSymbols)
+						body.append(debugSymbol(src, current.m_lineno));
 
-				std::string instruction;
+					ctx.labels.whileCount++;
+					size_t currWhileCount = ctx.labels.whileCount;
 
-				switch (next.m_type)
-				{
-					case TokenType::TT_EQ:  instruction = "BRE"; break;
-					case TokenType::TT_NEQ: instruction = "BNE"; break;
-					case TokenType::TT_GT:  instruction = "BRG"; break;
-					case TokenType::TT_GTE: instruction = "BGE"; break;
-					case TokenType::TT_LT:  instruction = "BRL"; break;
-					case TokenType::TT_LTE: instruction = "BLE"; break;
-
-					default: break;
-				}
-				
-				buf.advance();
-				if (!buf.hasNext() || !(isNumber(buf.current()) || buf.current().m_type == TokenType::TT_IDENTIFIER))
-				{
-					std::cerr << "Error: Expected number or identifier after comparison at line " << next.m_lineno << '\n';
-					std::cerr << next.m_lineno << ": " << getSourceLine(glob_src, next.m_lineno);
-					drawArrows(next.m_start, next.m_end, next.m_lineno);
-					exit(-1);
-				}
-				next = buf.current();
+					body.addLabel(irLabel(IrLabelKind::IL_WHILE, currWhileCount));
 
-				if (next.m_type == TokenType::TT_NUM)
-					code << "IMM R" << destCounter++ << " " << next.m_val << '\n';
-				else if (next.m_type == TokenType::TT_IDENTIFIER)
-					code << "LLOD R" << destCounter++ << " R1 " << "-" << locals.getOffset(next.m_val) << '\n';
+					size_t destCounter = 2;
+					loadCondition(body, ast.tokens[node.lhs], locals, destCounter);
+					loadCondition(body, ast.tokens[node.rhs], locals, destCounter);
 
-				code << instruction << " " << ".if" << currIfCount << " R" << destCounter-2 << " R" << destCounter-1 << "\n";
-				code << "JMP .endif"<< currIfCount << '\n';
-				code << ".if"<< currIfCount << '\n';
+					// Leaves the loop once the condition no longer holds
+					const IrCond cond = invertCond(getIrCond(ast.tokens[node.name]));
+					body.append( { IrOp::IR_BRANCH, {}, irLabel(IrLabelKind::IL_ENDWHILE, currWhileCount), irReg(destCounter - 2), irReg(destCounter - 1), cond } );
 
-				buf.advance();
-				if (!buf.hasNext() || buf.current().m_type != TokenType::TT_CLOSE_PAREN)
-				{
-					std::cerr << "Error: Expected ')' after condition at line " << next.m_lineno << '\n';
-					std::cerr << next.m_lineno << ": " << getSourceLine(glob_src, next.m_lineno);
-					drawArrows(next.m_start, next.m_end, next.m_lineno);
-					exit(-1);
+					locals.pushScope();
+					scopes.push_back( { node.body, index, currWhileCount, true } );
+					break;
 				}
-				next = buf.current();
-				
-				buf.advance();
-				if (!buf.hasNext() || buf.current().m_type != TokenType::TT_OPEN_BRACE)
-				{
-					std::cerr << "Error: Expecter '{' after closing ')' at line " << next.m_lineno << '\n';
-					std::cerr << next.m_lineno << ": " << getSourceLine(glob_src, next.m_lineno);
-					drawArrows(next.m_start, next.m_end, next.m_lineno);
-					exit(-1);
-				}
-				next = buf.current();
-				buf.advance();
 
-				std::vector<Token> body;
-				size_t scope = 0;
-				while (buf.hasNext())
+				// Imported by the declaration pass, the labels of the library are skipped here
+				case NodeType::NT_IMPORT:
 				{
-					if (buf.current().m_type == TokenType::TT_OPEN_BRACE)
-						++scope;
-					else if (buf.current().m_type == TokenType::TT_CLOSE_BRACE)
-					{
-						if (scope == 0)
-							break;
-						--scope;
-					}
-
-					body.push_back(buf.current());
-					buf.advance();
+					ctx.labels = ctx.decls.importEnd[index];
+					break;
 				}
 
-				const std::string& outcode = compile(linker, body, debugSymbols, false, false, true, true, locals, funcArgs);
-				code << outcode;
-				code << ".endif" << currIfCount << '\n';
-
-				break;
-			}
-
-			case TokenType::TT_WHILE:
-			{
-				if (debugSymbols)
-					code << "// " << getSourceLine(glob_src, current.m_lineno);
-
-				whileCount++;
-				size_t currWhileCount = whileCount;
-
-				int destCounter = 2;
-
-				code << ".while"<< currWhileCount << '\n';
-
-				buf.advance();
-				if (!buf.hasNext() || buf.current().m_type != TokenType::TT_OPEN_PAREN)
-				{
-					std::cerr << "Error: Expected '(' after while at line " << current.m_lineno << '\n';
-					std::cerr << current.m_lineno << ": " << getSourceLine(glob_src, current.m_lineno);
-					drawArrows(current.m_start, current.m_end, current.m_lineno);
-					exit(-1);
-				}
-				Token next = buf.current();
-				
-				buf.advance();
-				if (!buf.hasNext() || !(isNumber(buf.current()) || buf.current().m_type == TokenType::TT_IDENTIFIER))
+				case NodeType::NT_URCL_BLOCK:
 				{
-					std::cerr << "Error: Expected number or identifier after ( at line " << next.m_lineno << '\n';
-					std::cerr << next.m_lineno << ": " << getSourceLine(glob_src, next.m_lineno);
-					drawArrows(next.m_start, next.m_end, next.m_lineno);
-					exit(-1);
-				}
-				next = buf.current();
+					if (debugSymbols)
+						body.append(debugSymbol(src, current.m_lineno));
 
-				if (next.m_type == TokenType::TT_IDENTIFIER)
-					code << "LLOD R" << destCounter++ << " R1 " << "-" << locals.getOffset(buf.current().m_val) << '\n';
-				else if (next.m_type == TokenType::TT_NUM)
-					code << "IMM R" << destCounter++ << " " << buf.current().m_val << '\n';\
+					body.append( { IrOp::IR_URCL, {}, {}, irText(ast.tokens[node.lhs].m_val) } );
+					body.endStatement();
+					break;
+				}
 
-				buf.advance();
-				if (!buf.hasNext() || !isComparison(buf.current()))
+				case NodeType::NT_RETURN:
 				{
-					std::cerr << "Error: Expected comparison operator after identifier/number at line " << next.m_lineno << '\n';
-					std::cerr << next.m_lineno << ": " << getSourceLine(glob_src, next.m_lineno);
-					drawArrows(next.m_start, next.m_end, next.m_lineno);
-					exit(-1);
-				}
-				next = buf.current();
+					if (debugSymbols)
+						body.append(debugSymbol(src, current.m_lineno));
 
-				std::string instruction;
+					auto [val, _code] = parseExpr(src, diagnostics, getExpr(ast, node), locals, funcArgs);
+					if (_code.size() == 0)
+						body.append( { IrOp::IR_IMM, IR_WORD, irReg(2), val } );
+					else
+						body.append(_code);
+					body.endStatement();
 
-				switch (next.m_type)
-				{
-					case TokenType::TT_EQ:  instruction = "BNE"; break;
-					case TokenType::TT_NEQ: instruction = "BRE"; break;
-					case TokenType::TT_GT:  instruction = "BLE"; break;
-					case TokenType::TT_GTE: instruction = "BRL"; break;
-					case TokenType::TT_LT:  instruction = "BGE"; break;
-					case TokenType::TT_LTE: instruction = "BRG"; break;
-
-					default: break;
-				}
-				
-				buf.advance();
-				if (!buf.hasNext() || !(isNumber(buf.current()) || buf.current().m_type == TokenType::TT_IDENTIFIER))
-				{
-					std::cerr << "Error: Expected number or identifier after comparison at line " << next.m_lineno << '\n';
-					std::cerr << next.m_lineno << ": " << getSourceLine(glob_src, next.m_lineno);
-					drawArrows(next.m_start, next.m_end, next.m_lineno);
-					exit(-1);
+					body.append( { IrOp::IR_RET } );
+					body.endStatement();
+					break;
 				}
-				next = buf.current();
 
-				if (next.m_type == TokenType::TT_NUM)
-					code << "IMM R" << destCounter++ << " " << next.m_val << '\n';
-				else if (next.m_type == TokenType::TT_IDENTIFIER)
-					code << "LLOD R" << destCounter++ << " R1 " << "-" << locals.getOffset(next.m_val) << '\n';
+				default: break;
+			}
+		}
+		catch (const CompileError&)
+		{
+			// Later statements can still use a variable whose definition failed
+			if (node.type == NodeType::NT_VAR_DEFINITION)
+				locals.push(ast.tokens[node.name].m_val, current);
+		}
+	}
+}
 
-				code << instruction << " " << ".endwhile" << currWhileCount << " R" << destCounter-2 << " R" << destCounter-1 << "\n";
+// Hash of everything the code of a body depends on, apart from the functions it calls
+static uint64_t getFunctionKey(const SourceFile& src, const Ast& ast, const Node& node, const bool& debugSymbols)
+{
+	std::string key;
+	key += debugSymbols ? 'g' : '-';
+	for (TokenIndex i = node.begin; i < node.end; ++i)
+	{
+		key += char(ast.tokens[i].m_type);
+		key += ast.tokens[i].m_val;
+		key += '\0';
+	}
 
-				buf.advance();
-				if (!buf.hasNext() || buf.current().m_type != TokenType::TT_CLOSE_PAREN)
-				{
-					std::cerr << "Error: Expected ')' after condition at line " << next.m_lineno << '\n';
-					std::cerr << next.m_lineno << ": " << getSourceLine(glob_src, next.m_lineno);
-					drawArrows(next.m_start, next.m_end, next.m_lineno);
-					exit(-1);
-				}
-				next = buf.current();
-				
-				buf.advance();
-				if (!buf.hasNext() || buf.current().m_type != TokenType::TT_OPEN_BRACE)
-				{
-					std::cerr << "Error: Expecter '{' after closing ')' at line " << next.m_lineno << '\n';
-					std::cerr << next.m_lineno << ": " << getSourceLine(glob_src, next.m_lineno);
-					drawArrows(next.m_start, next.m_end, next.m_lineno);
-					exit(-1);
-				}
-				next = buf.current();
-				buf.advance();
+	// -g output quotes the source lines
+	if (debugSymbols && node.begin < node.end)
+		for (size_t line = ast.tokens[node.begin].m_lineno; line <= ast.tokens[node.end - 1].m_lineno; ++line)
+		{
+			key += src.getLine(line);
+			key += '\n';
+		}
 
-				std::vector<Token> body;
-				size_t scope = 0;
-				while (buf.hasNext())
-				{
-					if (buf.current().m_type == TokenType::TT_OPEN_BRACE)
-						++scope;
-					else if (buf.current().m_type == TokenType::TT_CLOSE_BRACE)
-					{
-						if (scope == 0)
-							break;
-						--scope;
-					}
+	return hashBytes(key);
+}
 
-					body.push_back(buf.current());
-					buf.advance();
-				}
+// Call nodes of a body in the order compileScope generates them, nested functions left out
+static void collectCalls(const Ast& ast, NodeIndex first, std::vector<NodeIndex>& calls)
+{
+	// Statement to visit next in every open scope, innermost last
+	std::vector<NodeIndex> scopes { first };
+	while (!scopes.empty())
+	{
+		const NodeIndex index = scopes.back();
+		if (index == NO_NODE)
+		{
+			scopes.pop_back();
+			continue;
+		}
 
-				const std::string& outcode = compile(linker, body, debugSymbols, false, false, true, true, locals, funcArgs);
-				code << outcode;
-				code << "JMP .while" << currWhileCount << '\n';
-				code << ".endwhile" << currWhileCount << '\n';
+		const Node& node = ast[index];
+		scopes.back() = node.next;
 
-				break;
-			}
+		if (node.type == NodeType::NT_CALL)
+			calls.push_back(index);
+		else if (node.type == NodeType::NT_IF || node.type == NodeType::NT_WHILE)
+			scopes.push_back(node.body);
+	}
+}
 
-			case TokenType::TT_IMPORT:
-			{
-				std::string libName;
+// Whether a body or anything nested in it imports a library. The labels the library
+// uses up depend on what was imported before, so such bodies are never cached
+static bool containsImport(const Ast& ast, NodeIndex first)
+{
+	std::vector<NodeIndex> scopes { first };
+	while (!scopes.empty())
+	{
+		const NodeIndex index = scopes.back();
+		if (index == NO_NODE)
+		{
+			scopes.pop_back();
+			continue;
+		}
 
-				buf.advance();
-				while (buf.hasNext() && buf.current().m_type != TokenType::TT_SEMICOLON)
-				{
-					Token curr = buf.current();
-					if (curr.m_type != TokenType::TT_IDENTIFIER && curr.m_type != TokenType::TT_URCL_BLOCK /* Since urcl literal becomes a urcl token */)
-					{
-						std::cerr << "Error: Expected module name after import at line " << curr.m_lineno << '\n';
-						std::cerr << curr.m_lineno << ": " << getSourceLine(glob_src, curr.m_lineno);
-						drawArrows(curr.m_start, curr.m_end, curr.m_lineno);
-						exit(-1);
-					}
+		const Node& node = ast[index];
+		scopes.back() = node.next;
 
-					libName += curr.m_val;
+		if (node.type == NodeType::NT_IMPORT)
+			return true;
+		if (node.type == NodeType::NT_IF || node.type == NodeType::NT_WHILE || node.type == NodeType::NT_FUNCTION)
+			scopes.push_back(node.body);
+	}
+	return false;
+}
 
-					buf.advance();
-					if (!buf.hasNext())
-					{
-						std::cerr << "Error: Expected '.' after module/submodule name at line " << current.m_lineno << '\n';
-						std::cerr << current.m_lineno << ": " << getSourceLine(glob_src, current.m_lineno);
-						drawArrows(current.m_start, current.m_end, current.m_lineno);
-						exit(-1);
-					}
-					curr = buf.current();
+// Code of a cached body with this compile's numbers filled in, if every call in it still resolves to the same function
+static std::optional<OutputBuffer> spliceCachedFunction(CompilerContext& context, const Linker& linker, const Ast& ast, const Declarations& decls, const FunctionJob& job, const CachedFunction& cached)
+{
+	std::vector<NodeIndex> calls;
+	collectCalls(ast, ast[job.node].body, calls);
+	if (calls.size() != cached.calls.size())
+		return std::nullopt;
 
-					if (curr.m_type == TokenType::TT_SEMICOLON) break;
-					else if (curr.m_type == TokenType::TT_DOT || curr.m_type == TokenType::TT_COLON)
-						libName += curr.m_val;
-					else
-					{
-						std::cerr << "Error: Expected '.' or ':' or ';' after module/submodule name at line " << curr.m_lineno << '\n';
-						std::cerr << curr.m_lineno << ": " << getSourceLine(glob_src, curr.m_lineno);
-						drawArrows(curr.m_start, curr.m_end, curr.m_lineno);
-						exit(-1);
-					}
+	for (size_t i = 0; i < calls.size(); ++i)
+	{
+		const Token& name = ast.tokens[ast[calls[i]].token];
+		if (name.m_val != cached.calls[i].name)
+			return std::nullopt;
 
-					buf.advance();
-				}
+		std::vector<Token> argTypes;
+		for (const TokenType& type: cached.calls[i].argTypes)
+			argTypes.push_back(Token(size_t(-1), type, "", size_t(-1), size_t(-1)));
 
-				importLibrary(linker, libName);
+		const Function* func = linker.findFunction(name, argTypes, decls.visibleAt[calls[i]]);
+		if (func == nullptr || func->getSignature() != cached.calls[i].signature)
+			return std::nullopt;
+	}
 
-				break;
-			}
+	const std::string_view text = cached.code;
+	OutputBuffer code;
+	size_t offset = 0;
+	for (const Relocation& relocation: cached.relocations)
+	{
+		code << text.substr(offset, relocation.offset - offset);
+		offset = relocation.offset;
 
-			case TokenType::TT_URCL_BLOCK:
-			{
-				if (debugSymbols)
-					code << "// " << getSourceLine(glob_src, current.m_lineno);
+		switch (relocation.type)
+		{
+			case RelocationType::RT_IF_LABEL:     code << job.start.ifCount + relocation.number; break;
+			case RelocationType::RT_WHILE_LABEL:  code << job.start.whileCount + relocation.number; break;
+			case RelocationType::RT_STRING_LABEL: code << context.strings.registerString(cached.strings[relocation.number]); break;
+		}
+	}
+	code << text.substr(offset);
 
-				buf.advance();
-				if (!buf.hasNext() || buf.current().m_type != TokenType::TT_STR)
-				{
-					std::cerr << "Error: Expected URCL Code in string after urcl at line " << current.m_lineno << '\n';
-					std::cerr << current.m_lineno << ": " << getSourceLine(glob_src, current.m_lineno);
-					drawArrows(current.m_start, current.m_end, current.m_lineno);
-					exit(-1);
-				}
-				const Token& curr = buf.current();
+	return code;
+}
 
-				code << curr.m_val << "\n\n";
+// Cuts the numbers out of generated code, making them relative to the function
+static CachedFunction makeCachedFunction(const FunctionJob& job, const OutputBuffer& code, const BodyContext& ctx)
+{
+	CachedFunction cached;
+	cached.calls = ctx.calls;
 
-				buf.advance();
-				if (!buf.hasNext() || buf.current().m_type != TokenType::TT_SEMICOLON)
-				{
-					std::cerr << "Error: Expected `;` after URCL code block at line " << curr.m_lineno << '\n';
-					std::cerr << curr.m_lineno << ": " << getSourceLine(glob_src, curr.m_lineno);
-					drawArrows(curr.m_start, curr.m_end, curr.m_lineno);
-					exit(-1);
-				}
+	const std::string text = code.toString();
+	std::unordered_map<std::string_view, size_t> stringIndex;
+	size_t offset = 0;
+	for (const Relocation& relocation: ctx.relocations)
+	{
+		cached.code.append(text, offset, relocation.offset - offset);
+		offset = relocation.offset + std::to_string(relocation.number).size();
 
+		Relocation relative { cached.code.size(), relocation.type, relocation.number };
+		switch (relocation.type)
+		{
+			case RelocationType::RT_IF_LABEL:    relative.number -= job.start.ifCount; break;
+			case RelocationType::RT_WHILE_LABEL: relative.number -= job.start.whileCount; break;
+			case RelocationType::RT_STRING_LABEL:
+			{
+				const auto [it, inserted] = stringIndex.try_emplace(relocation.string, cached.strings.size());
+				if (inserted)
+					cached.strings.emplace_back(relocation.string);
+				relative.number = it->second;
 				break;
 			}
+		}
+		cached.relocations.push_back(relative);
+	}
+	cached.code.append(text, offset);
 
-			case TokenType::TT_RETURN:
-			{
-				if (debugSymbols)
-					code << "// " << getSourceLine(glob_src, current.m_lineno);
+	return cached;
+}
 
-				buf.advance();
-				if (!buf.hasNext())
-				{
-					std::cerr << "Error: Expected expression after return at line " << current.m_lineno << '\n';
-					std::cerr << current.m_lineno << ": " << getSourceLine(glob_src, current.m_lineno);
-					drawArrows(current.m_start, current.m_end, current.m_lineno);
-					exit(-1);
-				}
+static OutputBuffer compileFunction(CompilerContext& context, const Linker& linker, const Ast& ast, const Declarations& decls, const FunctionJob& job, const bool& debugSymbols, Diagnostics& diagnostics)
+{
+	const Node& node = ast[job.node];
+	PhaseTimer timer(context.timeReport, Phase::PH_CODEGEN, &linker.getFunctions()[job.linkerIndex].getSignature());
+
+	const bool cacheable = isCacheEnabled() && !containsImport(ast, node.body);
+	const uint64_t key = cacheable ? getFunctionKey(context.src, ast, node, debugSymbols) : 0;
+	CachedFunction cached;
+	if (cacheable && loadFunctionCache(key, cached))
+		if (std::optional<OutputBuffer> code = spliceCachedFunction(context, linker, ast, decls, job, cached))
+			return *code;
+
+	SymbolTable funcArgsStack;
+	for (NodeIndex param = node.list; param != NO_NODE; param = ast[param].next)
+		funcArgsStack.push(ast.tokens[ast[param].name].m_val, ast.tokens[ast[param].token]);
+
+	OutputBuffer code;
+	BodyContext ctx { context, linker, ast, decls, debugSymbols, diagnostics, code, job.start };
+	SymbolTable funcLocals;
+	compileScope(ctx, node.body, true, funcLocals, funcArgsStack);
+	printBody(ctx);
+	if (context.memReport != nullptr)
+		context.memReport->addLocals(funcLocals.getPeakSize());
+
+	if (cacheable && !diagnostics.hasErrors())
+		storeFunctionCache(key, makeCachedFunction(job, code, ctx));
+
+	return code;
+}
 
-				std::vector<Token> expr;
-				while (buf.hasNext() && buf.current().m_type != TokenType::TT_SEMICOLON)
-				{
-					const Token& curr = buf.current();
+void compile(CompilerContext& context, OutputBuffer& code, Linker& linker, const std::vector<Token>& tokens, const bool& debugSymbols, const bool& emitFunctions, const bool& emitEntryPoint)
+{
+	const size_t errorCount = context.diagnostics.getErrorCount();
+	const Ast ast = [&context, &tokens]()
+	{
+		PhaseTimer timer(context.timeReport, Phase::PH_PARSE);
+		return parseAst(context.src, tokens, context.diagnostics);
+	}();
 
-					if (!isNumber(curr) && !isOperator(curr) && curr.m_type != TokenType::TT_IDENTIFIER && curr.m_type != TokenType::TT_OPEN_PAREN && curr.m_type != TokenType::TT_CLOSE_PAREN)
-					{
-						std::cerr << "Error: Expression cannot have non-number or non-operator or non-identifer or non-parenthesis tokens at line " << curr.m_lineno << '\n';
-						std::cerr << curr.m_lineno << ": " << getSourceLine(glob_src, curr.m_lineno);
-						drawArrows(curr.m_start, curr.m_end, curr.m_lineno);
-						exit(-1);
-					}
+	// Code is never generated from a tree with syntax errors in it
+	if (context.diagnostics.getErrorCount() != errorCount)
+		return;
 
-					expr.push_back(curr);
-					buf.advance();
-				}
+	if (emitEntryPoint)
+	{
+		code << "BITS == 32\n";
+		code << "MINHEAP 4096\n";
+		code << "MINSTACK 1024\n";
+		code << "MOV R1 SP\n\n";
+	}
 
-				auto [val, _code] = parseExpr(expr, locals, funcArgs);
-				if (_code.size() == 0)
-					code << "IMM R2 " << val << "\n\n";
-				else
-					code << _code << '\n';
-				
-				// cdecl calling convention exit
-				code << "MOV SP R1\nPOP R1\nRET\n\n";
+	// Interned up front, so symbol tables of bodies generated concurrently only have to look names up
+	for (const Token& tok: tokens)
+		if (tok.m_type == TokenType::TT_IDENTIFIER)
+			internSymbol(tok.m_val);
 
-				break;
-			}
+	const LabelCounters mainStart = context.labels;
 
-			case TokenType::TT_SEMICOLON: break;
+	Declarations decls;
+	decls.jobOf.resize(ast.nodes.size());
+	decls.visibleAt.resize(ast.nodes.size());
+	decls.importEnd.resize(ast.nodes.size());
+	{
+		PhaseTimer timer(context.timeReport, Phase::PH_DECLARE);
+		declareScope(context, linker, ast, decls, ast.root);
+	}
 
-			default:
-			{
-				std::cerr << "Unexpected token at line " << current.m_lineno << '\n';
-				std::cerr << current.m_lineno << ": " << getSourceLine(glob_src, current.m_lineno);
-				drawArrows(current.m_start, current.m_end, current.m_lineno);
-				exit(-1);
-			}
-		}
+	std::vector<OutputBuffer> bodies(decls.jobs.size());
+	std::vector<Diagnostics> bodyDiagnostics(decls.jobs.size());
+	parallelFor(decls.jobs.size(), [&](size_t i)
+	{
+		bodies[i] = compileFunction(context, linker, ast, decls, decls.jobs[i], debugSymbols, bodyDiagnostics[i]);
+	});
 
-		buf.advance();
+	// Reported in definition order, no matter which body finished first
+	for (size_t i = 0; i < decls.jobs.size(); ++i)
+	{
+		context.diagnostics.append(bodyDiagnostics[i]);
+		linker.setFunctionCode(decls.jobs[i].linkerIndex, bodies[i]);
 	}
 
+	{
+		PhaseTimer timer(context.timeReport, Phase::PH_CODEGEN);
+		BodyContext mainContext { context, linker, ast, decls, debugSymbols, context.diagnostics, code, mainStart };
+		SymbolTable locals, funcArgs;
+		compileScope(mainContext, ast.root, false, locals, funcArgs);
+		printBody(mainContext);
+		if (context.memReport != nullptr)
+			context.memReport->addLocals(locals.getPeakSize());
+	}
+
+	PhaseTimer timer(context.timeReport, Phase::PH_EMIT);
+
 	if (emitEntryPoint)
 		code << "\nCAL ._Hx4maini8\nMOV SP R1\nHLT\n\n";
 
-	if (popFrame)
-		code << "ADD SP SP " << locals.popFrame() << '\n';
-	
 	if (emitFunctions)
 	{
+		if (context.memReport != nullptr)
+			context.memReport->setOutput(linker.getFunctions(), context.strings);
+
 		for (const Function& func: linker.getFunctions())
 		{
 			code << '.' << func.getSignature() << '\n';
@@ -1300,9 +1123,6 @@ const std::string compile(Linker& linker, const std::vector<Token>& tokens, cons
 			code << "MOV SP R1\nPOP R1\nRET\n\n";
 		}
 
-		for (const std::string& str: getStrings())
-			code << str << "\n\n";
+		context.strings.emitStrings(code);
 	}
-
-	return code.str();
 }
@@ -0,0 +1,86 @@
+#include <compiler/sourceFile.h>
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+SourceFile::SourceFile()
+	: SourceFile(std::string())
+{}
+
+SourceFile::SourceFile(std::string src)
+	: m_src(std::make_shared<const std::string>(std::move(src)))
+{
+	const std::string& data = *m_src;
+
+	m_lineStarts.push_back(0);
+	for (size_t i = 0; i < data.size(); ++i)
+		if (data[i] == '\n')
+			m_lineStarts.push_back(i + 1);
+}
+
+const std::string& SourceFile::getSource() const
+{
+	return *m_src;
+}
+
+size_t SourceFile::getLineCount() const
+{
+	return m_lineStarts.size();
+}
+
+size_t SourceFile::getLineStart(const size_t& lineno) const
+{
+	if (lineno == 0 || lineno > m_lineStarts.size())
+		return m_src->size();
+
+	return m_lineStarts[lineno - 1];
+}
+
+size_t SourceFile::getColumn(const size_t& pos, const size_t& lineno) const
+{
+	return pos - getLineStart(lineno);
+}
+
+std::string_view SourceFile::getLine(const size_t& lineno) const
+{
+	const size_t start = getLineStart(lineno);
+	size_t end = lineno < m_lineStarts.size() ? m_lineStarts[lineno] - 1 : m_src->size();
+	if (end < start)
+		end = start;
+
+	return std::string_view(*m_src).substr(start, end - start);
+}
+
+bool readSourceFile(const std::filesystem::path& file, SourceFile& source)
+{
+	// A directory opens as a stream whose end is at a bogus offset
+	std::error_code error;
+	if (std::filesystem::is_directory(file, error))
+		return false;
+
+	std::ifstream inputFileStream(file, std::ios::binary);
+
+	if (!inputFileStream.is_open())
+		return false;
+
+	// tellg fails on streams that cannot seek
+	inputFileStream.seekg(0, std::ios::end);
+	const std::streamoff size = inputFileStream.tellg();
+	if (!inputFileStream || size < 0)
+		return false;
+
+	std::string src;
+	src.resize(size);
+	inputFileStream.seekg(0, std::ios::beg);
+	inputFileStream.read(src.data(), src.size());
+	if (!inputFileStream || size_t(inputFileStream.gcount()) != src.size())
+		return false;
+
+	source = SourceFile(std::move(src));
+	return true;
+}
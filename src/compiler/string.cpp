@@ -2,56 +2,63 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <mutex>
 
-struct CompilerString
+static std::string escapeString(std::string_view str)
 {
-	const std::string signature;
-	const std::string value;
-};
+	std::string escaped;
+	escaped.reserve(str.size());
 
-static std::vector<CompilerString> strings;
-static size_t strCount = 0;
-
-const std::string registerString(const std::string& str)
-{
-	for (const auto& s: strings)
-		if (s.value == str)
-			return s.signature;
-	
-	const std::string signature = ".str" + std::to_string(strCount);
-
-	std::string newStr;
-	for (const char& c: str)
-		switch (c)
+	size_t start = 0;
+	for (size_t i = 0; i < str.size(); ++i)
+	{
+		const char* escape;
+		switch (str[i])
 		{
-			case '\n':
-			{
-				newStr += "\\n";
-				break;
-			}
-			
-			case '\t':
-			{
-				newStr += "\\t";
-				break;
-			}
-			
-			default:
-			{
-				newStr += c;
-				break;
-			}
+			case '\n': escape = "\\n"; break;
+			case '\t': escape = "\\t"; break;
+			default: continue;
 		}
 
-	strings.push_back( { signature, newStr } );
-	strCount++;
-	return signature;
+		escaped.append(str.substr(start, i - start));
+		escaped.append(escape);
+		start = i + 1;
+	}
+	escaped.append(str.substr(start));
+
+	return escaped;
+}
+
+size_t StringTable::registerString(std::string_view str)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const auto [it, inserted] = m_index.try_emplace(std::string(str), m_strings.size());
+	if (inserted)
+		m_strings.push_back( { ".str" + std::to_string(it->second), escapeString(str) } );
+
+	return it->second;
+}
+
+void StringTable::emitStrings(OutputBuffer& out) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const auto& s: m_strings)
+		out << s.signature << "\nDW [ \"" << s.value << "\" 0 ]\n\n";
+}
+
+size_t StringTable::getCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_strings.size();
 }
 
-const std::vector<std::string> getStrings()
+size_t StringTable::getDataSize() const
 {
-	std::vector<std::string> retStrings;
-	for (const auto& s: strings)
-		retStrings.push_back(s.signature + '\n' + "DW [ \"" + s.value + "\" 0 ]");
-	return retStrings;
+	std::lock_guard<std::mutex> lock(m_mutex);
+	size_t size = 0;
+	for (const auto& s: m_strings)
+		size += s.value.size();
+	return size;
 }
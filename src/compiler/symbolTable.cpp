@@ -0,0 +1,115 @@
+#include <compiler/symbolTable.h>
+
+#include <algorithm>
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+#include <string_view>
+
+static std::unordered_map<std::string_view, SymbolId>& getSymbolIds()
+{
+	// Keys point into internTokenText's storage, so they outlive every source buffer
+	static std::unordered_map<std::string_view, SymbolId> ids;
+	return ids;
+}
+
+// Function bodies are generated concurrently. Their names are interned up front, so the exclusive lock is rarely taken
+static std::shared_mutex symbolIdsMutex;
+
+SymbolId internSymbol(std::string_view name)
+{
+	const SymbolId existing = findSymbol(name);
+	if (existing != NO_SYMBOL)
+		return existing;
+
+	std::unique_lock<std::shared_mutex> lock(symbolIdsMutex);
+	std::unordered_map<std::string_view, SymbolId>& ids = getSymbolIds();
+
+	const SymbolId id = SymbolId(ids.size());
+	return ids.emplace(internTokenText(name), id).first->second;
+}
+
+SymbolId findSymbol(std::string_view name)
+{
+	std::shared_lock<std::shared_mutex> lock(symbolIdsMutex);
+	const std::unordered_map<std::string_view, SymbolId>& ids = getSymbolIds();
+
+	const auto it = ids.find(name);
+	return it != ids.end() ? it->second : NO_SYMBOL;
+}
+
+void clearSymbols()
+{
+	std::unique_lock<std::shared_mutex> lock(symbolIdsMutex);
+	getSymbolIds().clear();
+}
+
+void SymbolTable::push(std::string_view name, const Token& type)
+{
+	const SymbolId id = internSymbol(name);
+	const size_t offset = m_symbols.empty() ? 1 : m_symbols.back().stackOffset + 1;
+
+	if (id >= m_lookup.size())
+		m_lookup.resize(id + 1, 0);
+
+	// Like the old linear search, lookups keep finding the first declaration of a name
+	if (m_lookup[id] == 0)
+		m_lookup[id] = uint32_t(m_symbols.size() + 1);
+
+	m_symbols.push_back( { id, offset, type } );
+	m_peak = std::max(m_peak, m_symbols.size());
+}
+
+void SymbolTable::pushScope()
+{
+	m_scopes.push_back(m_symbols.size());
+}
+
+const size_t SymbolTable::popScope()
+{
+	const size_t start = m_scopes.back();
+	m_scopes.pop_back();
+
+	const size_t count = m_symbols.size() - start;
+	while (m_symbols.size() > start)
+	{
+		const SymbolId id = m_symbols.back().id;
+		if (m_lookup[id] == m_symbols.size())
+			m_lookup[id] = 0;
+
+		m_symbols.pop_back();
+	}
+
+	return count;
+}
+
+const SymbolTable::Symbol* SymbolTable::find(std::string_view name) const
+{
+	const SymbolId id = findSymbol(name);
+	if (id == NO_SYMBOL || id >= m_lookup.size() || m_lookup[id] == 0)
+		return nullptr;
+
+	return &m_symbols[m_lookup[id] - 1];
+}
+
+const size_t SymbolTable::getOffset(std::string_view name) const
+{
+	const Symbol* symbol = find(name);
+	return symbol ? symbol->stackOffset : -1;
+}
+
+const Token SymbolTable::getType(std::string_view name) const
+{
+	const Symbol* symbol = find(name);
+	return symbol ? symbol->type : Token(-1, (TokenType) -1, "", -1, -1);
+}
+
+const size_t SymbolTable::getSize() const
+{
+	return m_symbols.size();
+}
+
+const size_t SymbolTable::getPeakSize() const
+{
+	return m_peak;
+}
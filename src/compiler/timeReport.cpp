@@ -0,0 +1,228 @@
+#include <compiler/timeReport.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <vector>
+
+static const char* const phaseNames[size_t(Phase::PH_COUNT) + 1] = {
+	"read source",
+	"compile cache",
+	"tokenize",
+	"parse",
+	"declarations",
+	"importLibrary",
+	"parseURCLSource",
+	"parseHexagnSource",
+	"codegen",
+	"linker",
+	"emission",
+	"outside phases"
+};
+
+const char* getPhaseName(const Phase& phase)
+{
+	return phaseNames[size_t(phase)];
+}
+
+// Slowest function bodies listed in the table, the JSON report lists all of them
+constexpr size_t FUNCTION_ROWS = 10;
+
+// CPU time of the calling thread, so concurrent bodies are not charged for each other
+static uint64_t getThreadCpuNs()
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+	timespec now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return uint64_t(now.tv_sec) * 1000000000 + now.tv_nsec;
+#else
+	return uint64_t(std::clock()) * 1000000000 / CLOCKS_PER_SEC;
+#endif
+}
+
+static uint64_t getProcessCpuNs()
+{
+	return uint64_t(std::clock()) * 1000000000 / CLOCKS_PER_SEC;
+}
+
+static uint64_t toNs(const std::chrono::steady_clock::duration& duration)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
+
+static std::string formatMs(const uint64_t& ns)
+{
+	char buffer[32];
+	std::snprintf(buffer, sizeof(buffer), "%.3f", ns / 1e6);
+	return buffer;
+}
+
+static std::string formatRow(const std::string& name, const TimeReport::Time& time)
+{
+	char buffer[256];
+	std::snprintf(buffer, sizeof(buffer), "  %-40s %12s %12s %8zu\n", name.c_str(), formatMs(time.wallNs).c_str(), formatMs(time.cpuNs).c_str(), time.count);
+	return buffer;
+}
+
+static std::string escapeJson(const std::string& str)
+{
+	std::string escaped;
+	for (const char& c: str)
+	{
+		if (c == '"' || c == '\\')
+			escaped += '\\';
+		if (uint8_t(c) < 0x20)
+			continue;
+		escaped += c;
+	}
+	return escaped;
+}
+
+static void writeJsonTime(std::ostream& out, const TimeReport::Time& time)
+{
+	out << "\"wall_ms\": " << formatMs(time.wallNs) << ", \"cpu_ms\": " << formatMs(time.cpuNs) << ", \"count\": " << time.count;
+}
+
+static void writeJsonList(std::ostream& out, const char* key, const std::vector<std::pair<std::string, TimeReport::Time>>& list)
+{
+	out << "  \"" << key << "\": [";
+	for (size_t i = 0; i < list.size(); ++i)
+	{
+		out << (i == 0 ? "\n" : ",\n") << "    { \"name\": \"" << escapeJson(list[i].first) << "\", ";
+		writeJsonTime(out, list[i].second);
+		out << " }";
+	}
+	out << (list.empty() ? "]" : "\n  ]");
+}
+
+TimeReport::TimeReport()
+	: m_start(std::chrono::steady_clock::now()), m_startCpuNs(getProcessCpuNs())
+{}
+
+void TimeReport::add(const Phase& phase, const Time& time)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	Time& total = m_phases[size_t(phase)];
+	total.wallNs += time.wallNs;
+	total.cpuNs += time.cpuNs;
+	total.count += time.count;
+}
+
+void TimeReport::addLibrary(const std::string& name, const Time& time)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_libraries.emplace_back(name, time);
+}
+
+void TimeReport::addFunction(const std::string& name, const Time& time)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_functions.emplace_back(name, time);
+}
+
+void TimeReport::print(std::ostream& out) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	char header[256];
+	std::snprintf(header, sizeof(header), "  %-40s %12s %12s %8s\n", "phase", "wall ms", "cpu ms", "count");
+
+	out << "Time report\n" << header;
+	for (size_t i = 0; i < size_t(Phase::PH_COUNT); ++i)
+		out << formatRow(phaseNames[i], m_phases[i]);
+	out << formatRow("total", { toNs(std::chrono::steady_clock::now() - m_start), getProcessCpuNs() - m_startCpuNs, 1 });
+
+	if (!m_functions.empty())
+	{
+		std::vector<std::pair<std::string, Time>> slowest = m_functions;
+		std::stable_sort(slowest.begin(), slowest.end(), [](const auto& lhs, const auto& rhs) { return lhs.second.wallNs > rhs.second.wallNs; });
+		slowest.resize(std::min(slowest.size(), FUNCTION_ROWS));
+
+		out << "\nSlowest function bodies\n";
+		for (const auto& [name, time]: slowest)
+			out << formatRow(name, time);
+	}
+
+	if (!m_libraries.empty())
+	{
+		out << "\nLibraries\n";
+		for (const auto& [name, time]: m_libraries)
+			out << formatRow(name, time);
+	}
+}
+
+void TimeReport::printJson(std::ostream& out) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	out << "{\n  \"phases\": [";
+	for (size_t i = 0; i < size_t(Phase::PH_COUNT); ++i)
+	{
+		out << (i == 0 ? "\n" : ",\n") << "    { \"name\": \"" << phaseNames[i] << "\", ";
+		writeJsonTime(out, m_phases[i]);
+		out << " }";
+	}
+	out << "\n  ],\n";
+
+	writeJsonList(out, "functions", m_functions);
+	out << ",\n";
+	writeJsonList(out, "libraries", m_libraries);
+	out << ",\n";
+
+	out << "  \"total\": { ";
+	writeJsonTime(out, { toNs(std::chrono::steady_clock::now() - m_start), getProcessCpuNs() - m_startCpuNs, 1 });
+	out << " }\n}\n";
+}
+
+// Innermost running phase of every thread, the timer is only set with a report
+static thread_local Phase currentPhase = Phase::PH_COUNT;
+static thread_local PhaseTimer* currentTimer = nullptr;
+
+Phase getCurrentPhase()
+{
+	return currentPhase;
+}
+
+PhaseTimer::PhaseTimer(TimeReport* report, const Phase& phase, const std::string* name)
+	: m_report(report), m_phase(phase), m_previousPhase(currentPhase), m_name(name)
+{
+	currentPhase = phase;
+	if (m_report == nullptr)
+		return;
+
+	m_parent = currentTimer;
+	currentTimer = this;
+
+	m_startWall = std::chrono::steady_clock::now();
+	m_startCpuNs = getThreadCpuNs();
+}
+
+PhaseTimer::~PhaseTimer()
+{
+	currentPhase = m_previousPhase;
+	if (m_report == nullptr)
+		return;
+
+	const uint64_t wallNs = toNs(std::chrono::steady_clock::now() - m_startWall);
+	const uint64_t cpuNs = getThreadCpuNs() - m_startCpuNs;
+
+	currentTimer = m_parent;
+	if (m_parent != nullptr)
+	{
+		m_parent->m_childWallNs += wallNs;
+		m_parent->m_childCpuNs += cpuNs;
+	}
+
+	m_report->add(m_phase, { wallNs - std::min(wallNs, m_childWallNs), cpuNs - std::min(cpuNs, m_childCpuNs), 1 });
+
+	if (m_name == nullptr)
+		return;
+
+	if (m_phase == Phase::PH_IMPORT)
+		m_report->addLibrary(*m_name, { wallNs, cpuNs, 1 });
+	else
+		m_report->addFunction(*m_name, { wallNs, cpuNs, 1 });
+}
@@ -1,16 +1,35 @@
 #include <string>
+#include <string_view>
+#include <unordered_set>
+#include <mutex>
 
 #include <compiler/token.h>
 #include <util.h>
 
-Token::Token(size_t lineno, TokenType type, std::string val, size_t start, size_t end)
-: m_lineno(lineno), m_type(type), m_val(val), m_start(start), m_end(end)
+Token::Token(size_t lineno, TokenType type, std::string_view val, size_t start, size_t end)
+: m_type(type), m_lineno(lineno), m_start(start), m_end(end), m_val(val)
 {}
 
 std::string Token::toString() const
 {
 	return "Token{ type='"  + std::to_string(m_type)
-			+ "', value='"  + m_val
+			+ "', value='"  + std::string(m_val)
 			+ "', line='"   + std::to_string(m_lineno)
 			+ "', start='"  + std::to_string(m_start) + "', end='" + std::to_string(m_end) + "' }";
 }
+
+// Node based, so views stay valid when the set rehashes
+static std::unordered_set<std::string> texts;
+static std::mutex textsMutex;
+
+std::string_view internTokenText(std::string_view text)
+{
+	std::lock_guard<std::mutex> lock(textsMutex);
+	return *texts.emplace(text).first;
+}
+
+void clearTokenTexts()
+{
+	std::lock_guard<std::mutex> lock(textsMutex);
+	texts.clear();
+}
@@ -1,38 +1,26 @@
 #include <importer/importHelper.h>
 
-#include <iostream>
-
 #include <string>
 #include <vector>
 #include <algorithm>
 #include <filesystem>
+#include <sstream>
 
 #include <importer/sourceParser.h>
+#include <importer/memoryLibrary.h>
+#include <compiler/timeReport.h>
 #include <util.h>
 
-// This holds the paths in which the compiler which search for libraries
-static std::vector<std::filesystem::path> libPaths = {
-#ifdef _WIN32
-	"C:\\Program Files (x86)\\hexagn\\hexagn-stdlib",
-#else
-	"/usr/lib/hexagn/hexagn-stdlib/",
-#endif
-
-	// For dev
-	"./hexagn-stdlib/"
-};
-
-// Protection against importing same file twice
-static std::vector<std::filesystem::path> imported;
-
-void importLibrary(Linker& targetLinker, const std::string& libName)
+void importLibrary(CompilerContext& context, Linker& targetLinker, const std::string& libName)
 {
+	PhaseTimer timer(context.timeReport, Phase::PH_IMPORT, &libName);
+
 	const std::vector<std::string>& vec = split(libName, ':');
 
 	if (vec.size() > 2)
 	{
-		std::cerr << "Error: Malformed file import " << libName << '\n';
-		exit(-1);
+		context.diagnostics.error("Error: Malformed file import " + libName + '\n');
+		return;
 	}
 
 	std::string libPath = replace(vec[0], ".", "/");
@@ -42,66 +30,92 @@ void importLibrary(Linker& targetLinker, const std::string& libName)
 	std::filesystem::path libDir;
 	bool libFound = false;
 
-	for (const auto& path: libPaths)
+	if (context.memoryLibrary != nullptr)
 	{
-		const std::filesystem::path libDirPath = path / libPath;
-		if (std::filesystem::exists(libDirPath))
+		libDir = libPath;
+		libFound = context.memoryLibrary->exists(libDir);
+	}
+	else
+	{
+		for (const auto& path: context.libPaths)
 		{
-			libFound = true;
-			libDir = libDirPath;
-			break;
+			const std::filesystem::path libDirPath = path / libPath;
+			if (std::filesystem::exists(libDirPath))
+			{
+				libFound = true;
+				libDir = libDirPath;
+				break;
+			}
+
+			// A library added here later would be found instead
+			context.dependencies.recordMissing(libDirPath);
 		}
 	}
 
 	if (!libFound)
 	{
-		std::cerr << "Error: Library " << libName << " does not exist\n";
-		exit(-1);
+		context.diagnostics.error("Error: Library " + libName + " does not exist\n");
+		return;
 	}
 
-	// We add it at the start because
-	// 1) If theres an error, the entire program quits anyways
-	// 2) Prevent file from importing itself
+	// Files are marked as imported before they are parsed, so a file cannot import itself
 
 	if (vec.size() == 1)
-		for (const auto& file: std::filesystem::directory_iterator(libDir))
-		{
-			if (file.is_directory()) continue;
-
-
-			const std::filesystem::path filePath = file;
-			if (std::find(imported.begin(), imported.end(), filePath) != imported.end()) return;
-			imported.push_back(filePath);
+	{
+		// Sorted, so functions are linked and duplicates are reported in the same order on every system
+		std::vector<std::filesystem::path> entries;
+		if (context.memoryLibrary != nullptr)
+			entries = context.memoryLibrary->listDirectory(libDir);
+		else
+			for (const auto& file: std::filesystem::directory_iterator(libDir))
+				if (!file.is_directory())
+					entries.push_back(file);
 
-			if (filePath.extension() == ".urcl")
-				parseURCLSource(targetLinker, file);
-			else if (filePath.extension() == ".hxgn")
-				parseHexagnSource(targetLinker, file);
-			else
+		std::vector<std::filesystem::path> files;
+		for (const std::filesystem::path& filePath: entries)
+		{
+			if (filePath.extension() != ".urcl" && filePath.extension() != ".hxgn")
 			{
-				std::cerr << "Error: Unrecognized file format for library file: " << file << '\n';
-				exit(-1);
+				std::ostringstream error;
+				error << "Error: Unrecognized file format for library file: " << filePath << '\n';
+				context.diagnostics.error(error.str());
+				continue;
 			}
+
+			files.push_back(filePath);
 		}
+		std::sort(files.begin(), files.end());
+		context.dependencies.recordDirectory(libDir, files);
+
+		std::erase_if(files, [&context](const std::filesystem::path& file)
+		{
+			if (std::find(context.imported.begin(), context.imported.end(), file) != context.imported.end()) return true;
+			context.imported.push_back(file);
+			return false;
+		});
+
+		parseLibraryFiles(context, targetLinker, files);
+	}
 	else
 	{
-		if (std::find(imported.begin(), imported.end(), libDir) != imported.end()) return;
-		imported.push_back(libDir);
+		if (std::find(context.imported.begin(), context.imported.end(), libDir) != context.imported.end()) return;
+		context.imported.push_back(libDir);
 
 		if (libDir.extension() == ".urcl")
-			parseURCLSource(targetLinker, libDir);
+			parseURCLSource(context, targetLinker, libDir);
 		else if (libDir.extension() == ".hxgn")
-			parseHexagnSource(targetLinker, libDir);
+			parseHexagnSource(context, targetLinker, libDir);
 		else
 		{
-			std::cerr << "Error: Unrecognized file format for library file: " << libDir << '\n';
-			exit(-1);
+			std::ostringstream error;
+			error << "Error: Unrecognized file format for library file: " << libDir << '\n';
+			context.diagnostics.error(error.str());
 		}
 	}
 }
 
-void addPath(const std::string& path)
+void addPath(CompilerContext& context, const std::string& path)
 {
 	const std::filesystem::path _path = path;
-	libPaths.push_back(_path);
+	context.libPaths.push_back(_path);
 }
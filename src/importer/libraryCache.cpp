@@ -0,0 +1,158 @@
+#include <importer/libraryCache.h>
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <util.h>
+#include <compiler/cacheFile.h>
+#include <compiler/parser.h>
+
+// Bumped whenever the layout below or the code the parsers generate changes
+constexpr uint32_t CACHE_VERSION = 2;
+constexpr char CACHE_MAGIC[4] = { 'H', 'X', 'L', 'C' };
+
+// Entry tags
+constexpr uint8_t ENTRY_CALL     = 'C';
+constexpr uint8_t ENTRY_FUNCTION = 'F';
+
+// Set by every compile of a batch, which run on threads side by side
+static std::atomic<bool> cacheEnabled = true;
+
+void setLibraryCacheEnabled(const bool& enabled)
+{
+	cacheEnabled = enabled;
+}
+
+static std::filesystem::path getLibraryCacheFile(const std::filesystem::path& file)
+{
+	std::error_code ec;
+	const std::string key = std::filesystem::absolute(file, ec).string();
+
+	return getCacheFile(getCacheDirectory(), hashBytes(key), ".hxlc");
+}
+
+static int64_t getModificationTime(const std::filesystem::path& file)
+{
+	std::error_code ec;
+	return std::filesystem::last_write_time(file, ec).time_since_epoch().count();
+}
+
+void LibraryRecorder::addCall(const Token& name, const std::vector<Token>& argTypes, const Function& resolved)
+{
+	writeValue(m_entries, ENTRY_CALL);
+	writeString(m_entries, name.m_val);
+	writeTokens(m_entries, argTypes);
+	writeString(m_entries, resolved.getSignature());
+}
+
+void LibraryRecorder::addFunction(const Function& function)
+{
+	writeValue(m_entries, ENTRY_FUNCTION);
+	writeToken(m_entries, function.name);
+	writeToken(m_entries, function.returnType);
+	writeTokens(m_entries, function.argTypes);
+
+	writeString(m_entries, function.code.toString());
+}
+
+const std::string& LibraryRecorder::getEntries() const
+{
+	return m_entries;
+}
+
+static void writeHeader(std::string& out, const std::filesystem::path& file, std::string_view source)
+{
+	out.append(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	writeValue(out, CACHE_VERSION);
+	writeValue(out, getModificationTime(file));
+	writeValue(out, uint64_t(source.size()));
+	writeValue(out, hashBytes(source));
+	writeString(out, file.string());
+}
+
+LibraryCacheEntry openLibraryCache(const std::filesystem::path& file, std::string_view source)
+{
+	if (!cacheEnabled || !isCacheEnabled())
+		return {};
+
+	const std::filesystem::path cacheFile = getLibraryCacheFile(file);
+	if (cacheFile.empty())
+		return {};
+
+	std::shared_ptr<const MappedFile> mapped = std::make_shared<const MappedFile>(cacheFile);
+
+	// The header has to match byte for byte
+	std::string header;
+	writeHeader(header, file, source);
+	if (mapped->data().substr(0, header.size()) != header)
+		return {};
+
+	return { mapped, mapped->data().substr(header.size()) };
+}
+
+bool applyLibraryCache(Linker& targetLinker, const LibraryCacheEntry& entry)
+{
+	CacheReader reader(entry.entries);
+	const size_t functionCount = targetLinker.getFunctions().size();
+
+	while (reader.isValid() && !reader.atEnd())
+	{
+		const uint8_t tag = reader.read<uint8_t>();
+
+		if (tag == ENTRY_CALL)
+		{
+			const Token name = Token(size_t(-1), TokenType::TT_IDENTIFIER, reader.readString(), size_t(-1), size_t(-1));
+			const std::vector<Token> argTypes = reader.readTokens();
+			const std::string_view signature = reader.readString();
+
+			// Calls may resolve differently with other libraries imported, then the file is parsed again
+			const Function* resolved = targetLinker.findFunction(name, argTypes);
+			if (!reader.isValid() || resolved == nullptr || resolved->getSignature() != signature)
+				break;
+		}
+		else if (tag == ENTRY_FUNCTION)
+		{
+			const Token name = reader.readToken();
+			const Token returnType = reader.readToken();
+			Function func { name, returnType, reader.readTokens() };
+			func.code << reader.readString();
+
+			if (!reader.isValid())
+				break;
+
+			targetLinker.addFunction(func);
+		}
+		else
+			break;
+	}
+
+	if (!reader.isValid() || !reader.atEnd())
+	{
+		targetLinker.removeFunctionsFrom(functionCount);
+		return false;
+	}
+
+	return true;
+}
+
+void storeLibraryCache(const std::filesystem::path& file, std::string_view source, const LibraryRecorder& recorder)
+{
+	if (!cacheEnabled || !isCacheEnabled())
+		return;
+
+	const std::filesystem::path cacheFile = getLibraryCacheFile(file);
+	if (cacheFile.empty())
+		return;
+
+	std::string data;
+	writeHeader(data, file, source);
+	data += recorder.getEntries();
+
+	writeCacheFile(cacheFile, data);
+}
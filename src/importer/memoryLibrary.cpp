@@ -0,0 +1,48 @@
+#include <importer/memoryLibrary.h>
+
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+void MemoryLibrary::addFile(const std::filesystem::path& path, std::string source)
+{
+	m_files.insert_or_assign(path.lexically_normal(), SourceFile(std::move(source)));
+}
+
+void MemoryLibrary::clear()
+{
+	m_files.clear();
+}
+
+const SourceFile* MemoryLibrary::findFile(const std::filesystem::path& path) const
+{
+	const auto it = m_files.find(path.lexically_normal());
+	return it != m_files.end() ? &it->second : nullptr;
+}
+
+bool MemoryLibrary::exists(const std::filesystem::path& path) const
+{
+	const std::filesystem::path normal = path.lexically_normal();
+	if (m_files.count(normal) != 0)
+		return true;
+
+	for (const auto& [file, source]: m_files)
+		for (std::filesystem::path dir = file.parent_path(); !dir.empty(); dir = dir.parent_path())
+			if (dir == normal)
+				return true;
+
+	return false;
+}
+
+std::vector<std::filesystem::path> MemoryLibrary::listDirectory(const std::filesystem::path& dir) const
+{
+	const std::filesystem::path normal = dir.lexically_normal();
+
+	std::vector<std::filesystem::path> files;
+	for (const auto& [file, source]: m_files)
+		if (file.parent_path() == normal)
+			files.push_back(file);
+
+	return files;
+}
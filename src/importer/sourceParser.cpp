@@ -1,66 +1,131 @@
 #include <importer/sourceParser.h>
 
 #include <iostream>
-#include <fstream>
-#include <sstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
 
 #include <util.h>
 #include <compiler/lexer.h>
 #include <compiler/parser.h>
 #include <compiler/token.h>
+#include <compiler/keywords.h>
+#include <compiler/timeReport.h>
+#include <importer/libraryCache.h>
+#include <importer/memoryLibrary.h>
 
-const TokenType strToType(const std::string& val);
+const TokenType strToType(std::string_view val);
 
-void parseURCLSource(Linker& targetLinker, const std::filesystem::path& file)
+// Cuts off a trailing `//` comment that is not inside a quoted literal, along with trailing whitespace
+static std::string_view stripComment(std::string_view line)
 {
-	// Storing entire source
-	std::string src;
+	char quote = '\0';
+	size_t end = line.size();
 
-	// File stream to read input file
-	std::ifstream inputFileStream(file.string());
-
-	if (!inputFileStream.is_open())
-	{
-		std::cout << "Error: Could not open input file: " << file.string() << '\n';
-		exit(-1);
-	}
-	
-	// Get all non-comment tokens into src
-	std::string str;
-	while(std::getline(inputFileStream, str))
+	for (size_t i = 0; i < line.size(); ++i)
 	{
-		auto _toks = split(str, ' ');
-		
-		for (auto tok: _toks)
+		const char& c = line[i];
+
+		if (quote != '\0')
+		{
+			if (c == '\\')
+				++i;
+			else if (c == quote)
+				quote = '\0';
+		}
+		else if (c == '"' || c == '\'')
+			quote = c;
+		else if (c == '/' && i + 1 < line.size() && line[i + 1] == '/')
 		{
-			tok = replace(tok, "\t", "  ");
+			end = i;
+			break;
+		}
+	}
 
-			if (tok.starts_with("//"))
-				break;
+	line = line.substr(0, end);
+	while (!line.empty() && isspace(line.back()))
+		line.remove_suffix(1);
 
-			src += tok + ' ';
-		}
+	return line;
+}
 
-		src += '\n';
+// Splits a line on any whitespace, the words view the line they came from
+static std::vector<std::string_view> splitWords(std::string_view line)
+{
+	std::vector<std::string_view> words;
+
+	size_t i = 0;
+	while (i < line.size())
+	{
+		while (i < line.size() && isspace(line[i])) ++i;
+
+		const size_t start = i;
+		while (i < line.size() && !isspace(line[i])) ++i;
+
+		if (i > start)
+			words.push_back(line.substr(start, i - start));
 	}
 
-	// We dont need the input file stream anymore, so close it
-	inputFileStream.close();
+	return words;
+}
+
+// A @CALL of a library function, resolved when the file is linked
+struct URCLCall
+{
+	Token name;
+	std::vector<Token> argTypes;
+	// Offset into the function code the call instructions go at
+	size_t offset;
+};
+
+struct URCLFunction
+{
+	Token name;
+	Token returnType;
+	std::vector<Token> argTypes;
+	std::string code;
+	std::vector<URCLCall> calls;
+};
+
+// A URCL library file, read and parsed without touching the linker or any other
+// shared state so the files of a library directory can be loaded concurrently.
+// Tokens view the source buffer until the linker gives them their own text
+struct URCLSource
+{
+	std::filesystem::path file;
+	SourceFile source;
+
+	LibraryCacheEntry cache;
+
+	bool parsed = false;
+	std::vector<URCLFunction> functions;
+	// First syntax error, reported after the functions before it have been linked
+	std::string error;
+};
+
+static void parseURCLFunctions(URCLSource& src)
+{
+	const SourceFile& source = src.source;
+	const std::string file = src.file.string();
+	const size_t lineCount = source.getLineCount();
+
+	src.parsed = true;
 
-	const std::vector<std::string>& lines = split(src, '\n');
-	for (size_t i = 0; i < lines.size(); ++i)
+	for (size_t i = 1; i <= lineCount; ++i)
 	{
-		std::vector<std::string> toks = split(lines[i], ' ');
+		std::vector<std::string_view> toks = splitWords(stripComment(source.getLine(i)));
 		if (toks.size() == 0)
 			continue;
-		
 
 		if (toks[0] == "@FUNC")
 		{
 			if (toks.size() != 2)
 			{
-				std::cerr << "Error: @FUNC expects one argument (name) in library file " << file.string() << " at line " << i << '\n';
-				exit(-1);
+				src.error = "Error: @FUNC expects one argument (name) in library file " + file + " at line " + std::to_string(i) + '\n';
+				return;
 			}
 
 			const Token name = Token(size_t(-1), TokenType::TT_IDENTIFIER, toks[1], size_t(-1), size_t(-1));
@@ -68,19 +133,19 @@ void parseURCLSource(Linker& targetLinker, const std::filesystem::path& file)
 			do
 			{
 				++i;
-				toks = split(lines[i], ' ');
+				toks = splitWords(stripComment(source.getLine(i)));
 			}
-			while (toks.size() == 0);
+			while (toks.size() == 0 && i < lineCount);
 
-			if (toks[0] != "@SIGNATURE")
+			if (toks.size() == 0 || toks[0] != "@SIGNATURE")
 			{
-				std::cerr << "Error: Expected @SIGNATURE on line after @FUNC in library file " << file.string() << " at line " << i << '\n';
-				exit(-1);
+				src.error = "Error: Expected @SIGNATURE on line after @FUNC in library file " + file + " at line " + std::to_string(i) + '\n';
+				return;
 			}
-			if (toks.size() < 1)
+			if (toks.size() < 2)
 			{
-				std::cerr << "Error: @SIGNATURE expects one or more argument(s) (returnType args...) in library file " << file.string() << " at line " << i << '\n';
-				exit(-1);
+				src.error = "Error: @SIGNATURE expects one or more argument(s) (returnType args...) in library file " + file + " at line " + std::to_string(i) + '\n';
+				return;
 			}
 			const Token& returnType = Token(size_t(-1), strToType(toks[1]), toks[1], size_t(-1), size_t(-1));
 			std::vector<Token> argTypes;
@@ -89,17 +154,17 @@ void parseURCLSource(Linker& targetLinker, const std::filesystem::path& file)
 					Token(size_t(-1), strToType(toks[j]), toks[j], size_t(-1), size_t(-1))
 				);
 
-			Function func { name, returnType, argTypes };
+			URCLFunction func { name, returnType, argTypes };
 
-			std::stringstream funcCode;
-			while (i < lines.size() && toks.size() > 0)
+			while (i < lineCount)
 			{
 				++i;
-				toks = split(lines[i], ' ');
+				const std::string_view line = stripComment(source.getLine(i));
+				toks = splitWords(line);
 				if (toks.size() == 0) continue;
 
 				if (toks[0] == "@RETURN")
-					funcCode << "MOV SP R1\nPOP R1\nRET\n\n";
+					func.code += "MOV SP R1\nPOP R1\nRET\n\n";
 
 				else if (toks[0] == "@END")
 					break;
@@ -108,90 +173,290 @@ void parseURCLSource(Linker& targetLinker, const std::filesystem::path& file)
 				{
 					if (toks.size() < 2)
 					{
-						std::cerr << "Error: @CALL needs atleast a function name after it at library file " << file.string() << " at line " << i << '\n';
-						exit(-1);
+						src.error = "Error: @CALL needs atleast a function name after it at library file " + file + " at line " + std::to_string(i) + '\n';
+						return;
 					}
 
-					const Token& name = Token(i, TokenType::TT_IDENTIFIER, toks[1], 6, 6 + toks[1].size());
+					const size_t nameStart = toks[1].data() - line.data();
+					const Token& name = Token(i, TokenType::TT_IDENTIFIER, toks[1], nameStart, nameStart + toks[1].size());
 					std::vector<Token> args;
-					size_t start = name.m_end + 1;
 					for (size_t j = 2; j < toks.size(); ++j)
 					{
-						const std::string& argStr = toks[j];
+						const std::string_view& argStr = toks[j];
+						const size_t start = argStr.data() - line.data();
 						args.push_back(Token(i, strToType(argStr), argStr, start, start + argStr.size()));
-						start += argStr.size() + 1;
 					}
 
-					const Function& func2 = targetLinker.getFunction(src, name, args);
-
-					funcCode << "CAL ." << func2.getSignature() << '\n';
-					funcCode << "ADD SP SP " << args.size() << '\n';
+					func.calls.push_back( { name, args, func.code.size() } );
 				}
 
 				else
-					funcCode << lines[i] << '\n';
+				{
+					func.code += line;
+					func.code += '\n';
+				}
 			}
-			func.code = funcCode.str();
 
-			targetLinker.addFunction(func);
+			src.functions.push_back(std::move(func));
 		}
 	}
 }
 
-const TokenType strToType(const std::string& val)
-{
-		 if (val == "void")    return TokenType::TT_VOID;
-	else if (val == "int8"
-		  || val == "int16"
-		  || val == "int32"
-		  || val == "int64")   return TokenType::TT_INT;
-	else if (val == "uint8"
-		  || val == "uint16"
-		  || val == "uint32"
-		  || val == "uint64")  return TokenType::TT_UINT;
-	else if (val == "float32"
-		  || val == "float64") return TokenType::TT_FLOAT;
-	else if (val == "string")  return TokenType::TT_STRING;
-	else if (val == "char")    return TokenType::TT_CHARACTER;
-	else                       return (TokenType) -1;
+static URCLSource loadURCLSource(const std::filesystem::path& file)
+{
+	URCLSource src { file };
+	if (!readSourceFile(file, src.source))
+	{
+		src.parsed = true;
+		src.error = "Error: Could not read library file: " + file.string() + '\n';
+		return src;
+	}
+
+	// Files with a usable cache entry are only parsed if the entry turns out not to fit the linker
+	src.cache = openLibraryCache(file, src.source.getSource());
+	if (!src.cache.mapping)
+		parseURCLFunctions(src);
+
+	return src;
 }
 
-void parseHexagnSource(Linker& targetLinker, const std::filesystem::path& file)
+// A library file preloaded by a compile server, used while the file keeps its mtime and size
+struct ResidentSource
+{
+	std::filesystem::file_time_type mtime;
+	uintmax_t size;
+	URCLSource src;
+};
+
+// By absolute path. Only filled before a server forks its workers, so they read it without locking.
+// Never destroyed, so workers do not spend their exit freeing the parsed libraries
+static std::unordered_map<std::string, ResidentSource>& residentSources = *new std::unordered_map<std::string, ResidentSource>();
+
+static std::string getResidentKey(const std::filesystem::path& file)
 {
-	// Storing entire source
-	std::string src;
+	std::error_code ec;
+	return std::filesystem::absolute(file, ec).lexically_normal().string();
+}
+
+// Parsed files of in-memory libraries, by path. An entry is used while the library
+// still holds the same source buffer, which the entry keeps alive, so a library
+// kept across compiles is only parsed once
+static std::mutex memorySourcesMutex;
+static std::unordered_map<std::string, URCLSource>& memorySources = *new std::unordered_map<std::string, URCLSource>();
+
+void clearMemorySources()
+{
+	std::lock_guard<std::mutex> lock(memorySourcesMutex);
+	memorySources.clear();
+}
+
+static URCLSource readMemoryURCLSource(const MemoryLibrary& library, const std::filesystem::path& file)
+{
+	URCLSource src { file };
+
+	const SourceFile* source = library.findFile(file);
+	if (source == nullptr)
+	{
+		src.parsed = true;
+		src.error = "Error: Could not open library file: " + file.string() + '\n';
+		return src;
+	}
+
+	const std::string key = file.lexically_normal().string();
+	{
+		std::lock_guard<std::mutex> lock(memorySourcesMutex);
+		const auto it = memorySources.find(key);
+		if (it != memorySources.end() && &it->second.source.getSource() == &source->getSource())
+			return it->second;
+	}
+
+	src.source = *source;
+	parseURCLFunctions(src);
+
+	std::lock_guard<std::mutex> lock(memorySourcesMutex);
+	memorySources.insert_or_assign(key, src);
+	return src;
+}
 
-	// File stream to read input file
-	std::ifstream inputFileStream(file.string());
+static URCLSource readURCLSource(CompilerContext& context, const std::filesystem::path& file)
+{
+	if (context.memoryLibrary != nullptr)
+		return readMemoryURCLSource(*context.memoryLibrary, file);
 
-	if (!inputFileStream.is_open())
+	CompileDependencies& dependencies = context.dependencies;
+	if (!residentSources.empty())
 	{
-		std::cout << "Error: Could not open input file: " << file.string() << '\n';
-		exit(-1);
+		const auto it = residentSources.find(getResidentKey(file));
+
+		std::error_code ec;
+		if (it != residentSources.end() && std::filesystem::last_write_time(file, ec) == it->second.mtime && std::filesystem::file_size(file, ec) == it->second.size)
+		{
+			URCLSource src = it->second.src;
+			src.file = file;
+			dependencies.recordFile(file, src.source.getSource());
+			return src;
+		}
 	}
-	
-	// Get all non-comment tokens into src
-	std::string str;
-	while(std::getline(inputFileStream, str))
+
+	URCLSource src = loadURCLSource(file);
+	dependencies.recordFile(file, src.source.getSource());
+	return src;
+}
+
+static void linkURCLSource(CompilerContext& context, Linker& targetLinker, URCLSource& src)
+{
+	if (src.cache.mapping && applyLibraryCache(targetLinker, src.cache))
+		return;
+
+	if (!src.parsed)
+		parseURCLFunctions(src);
+
+	const size_t errorCount = context.diagnostics.getErrorCount();
+	LibraryRecorder recorder;
+
+	for (const URCLFunction& parsed: src.functions)
 	{
-		auto _toks = split(str, ' ');
+		Function func { parsed.name, parsed.returnType, parsed.argTypes };
 
-		for (auto tok: _toks)
+		// A function with a call that does not resolve is left out
+		try
 		{
-			tok = replace(tok, "\t", "");
+			size_t written = 0;
+			for (const URCLCall& call: parsed.calls)
+			{
+				const Function& func2 = targetLinker.getFunction(context.diagnostics, src.source, call.name, call.argTypes);
+				recorder.addCall(call.name, call.argTypes, func2);
+
+				func.code << std::string_view(parsed.code).substr(written, call.offset - written);
+				written = call.offset;
+
+				func.code << "CAL ." << func2.getSignature() << '\n';
+				func.code << "ADD SP SP " << call.argTypes.size() << '\n';
+			}
+			func.code << std::string_view(parsed.code).substr(written);
+		}
+		catch (const CompileError&)
+		{
+			continue;
+		}
+
+		recorder.addFunction(func);
+		targetLinker.addFunction(func);
+	}
+
+	if (!src.error.empty())
+		context.diagnostics.error(src.error);
+
+	// A file with errors is checked again on every import rather than cached.
+	// In-memory files have no file the entry could be checked against
+	if (context.diagnostics.getErrorCount() == errorCount && context.memoryLibrary == nullptr)
+		storeLibraryCache(src.file, src.source.getSource(), recorder);
+}
+
+void parseURCLSource(CompilerContext& context, Linker& targetLinker, const std::filesystem::path& file)
+{
+	PhaseTimer timer(context.timeReport, Phase::PH_URCL);
+	URCLSource src = readURCLSource(context, file);
+	linkURCLSource(context, targetLinker, src);
+}
 
-			if (tok.starts_with("//"))
-				break;
+const TokenType strToType(std::string_view val)
+{
+	const Keyword* keyword = findKeyword(val);
+	if (keyword == nullptr || keyword->mangled.empty())
+		return (TokenType) -1;
+
+	return keyword->type;
+}
 
-			src += tok + ' ';
+void parseHexagnSource(CompilerContext& context, Linker& targetLinker, const std::filesystem::path& file)
+{
+	PhaseTimer timer(context.timeReport, Phase::PH_HEXAGN);
+
+	// Diagnostics and debug symbols of the importing file must keep pointing at its own source
+	const SourceFile importerSrc = context.src;
+	if (context.memoryLibrary != nullptr)
+	{
+		const SourceFile* source = context.memoryLibrary->findFile(file);
+		if (source == nullptr)
+		{
+			context.diagnostics.error("Error: Could not open library file: " + file.string() + '\n');
+			return;
 		}
+		context.src = *source;
+	}
+	else if (!readSourceFile(file, context.src))
+	{
+		context.diagnostics.error("Error: Could not read library file: " + file.string() + '\n');
+		return;
+	}
+	context.dependencies.recordFile(file, context.src.getSource());
 
-		src += '\n';
+	// Only the functions are kept, the importing file emits them along with its own
+	const size_t errorCount = context.diagnostics.getErrorCount();
+	std::vector<Token> toks;
+	{
+		PhaseTimer tokenizeTimer(context.timeReport, Phase::PH_TOKENIZE);
+		toks = tokenize(context.src, context.diagnostics);
+	}
+	if (context.memReport != nullptr)
+		context.memReport->addTokens(toks);
+	if (context.diagnostics.getErrorCount() == errorCount)
+	{
+		OutputBuffer discarded;
+		compile(context, discarded, targetLinker, toks, false, false, false);
 	}
 
-	// We dont need the input file stream anymore, so close it
-	inputFileStream.close();
+	context.src = importerSrc;
+}
 
-	const std::vector<Token>& toks = tokenize(src);
-	compile(targetLinker, toks, false, true, false);
+void parseLibraryFiles(CompilerContext& context, Linker& targetLinker, const std::vector<std::filesystem::path>& files)
+{
+	// URCL files are read, checked against the cache and parsed concurrently
+	std::vector<URCLSource> urclSources(files.size());
+	{
+		PhaseTimer timer(context.timeReport, Phase::PH_URCL);
+		parallelFor(files.size(), [&context, &files, &urclSources](size_t i)
+		{
+			if (files[i].extension() == ".urcl")
+				urclSources[i] = readURCLSource(context, files[i]);
+		});
+	}
+
+	// and linked in the given order, since calls resolve against the functions linked before them
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		if (files[i].extension() == ".urcl")
+		{
+			PhaseTimer timer(context.timeReport, Phase::PH_URCL);
+			linkURCLSource(context, targetLinker, urclSources[i]);
+		}
+		else
+			parseHexagnSource(context, targetLinker, files[i]);
+	}
+}
+
+void preloadLibraryFiles(const std::filesystem::path& dir)
+{
+	std::error_code ec;
+	std::vector<std::filesystem::path> files;
+	for (const auto& entry: std::filesystem::recursive_directory_iterator(dir, ec))
+		if (entry.is_regular_file() && entry.path().extension() == ".urcl")
+			files.push_back(getResidentKey(entry.path()));
+
+	std::vector<ResidentSource> loaded(files.size());
+	parallelFor(files.size(), [&files, &loaded](size_t i)
+	{
+		std::error_code ec;
+		loaded[i].mtime = std::filesystem::last_write_time(files[i], ec);
+		loaded[i].size = std::filesystem::file_size(files[i], ec);
+
+		// Parsed even with a cache entry, in case the entry does not fit a compile
+		loaded[i].src = loadURCLSource(files[i]);
+		if (!loaded[i].src.parsed)
+			parseURCLFunctions(loaded[i].src);
+	});
+
+	for (size_t i = 0; i < files.size(); ++i)
+		residentSources.insert_or_assign(files[i].string(), std::move(loaded[i]));
 }
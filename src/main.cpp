@@ -1,29 +1,43 @@
 #include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <optional>
 #include <string>
+#include <vector>
 
 #include <util.h>
+#include <batch.h>
+#include <server.h>
 #include <compiler/compiler.h>
+#include <compiler/cacheFile.h>
+#include <compiler/timeReport.h>
+#include <compiler/memReport.h>
 #include <importer/importHelper.h>
+#include <importer/libraryCache.h>
 
-int main(int argc, char* argv[])
+static int compileCommandLine(const std::vector<std::string>& args, std::ostream& log)
 {
-	if (argc == 1)
-	{
-		std::cerr << "Invalid number of arguments\n" << "Usage: hexagn file.hxgn or hexagn file.hxgn -o file.urcl\n";
-		return -1;
-	}
+	const size_t argc = args.size();
+	const char* const programName = args[0].c_str();
 
 	std::string inputFileName;
 	std::string outputFileName = "out.urcl";
 	bool debugSymbols = false;
 	bool emitEntryPoint = true;
+	CompilerContext context;
+
+	// -ftime-report prints a table once the compile is done, -ftime-report=json the same as JSON
+	std::optional<TimeReport> timeReport;
+	bool timeReportJson = false;
+	// -fmem-report prints sizes and allocation counts once the compile is done
+	std::optional<MemReport> memReport;
 
 	// Reused index variable for arguments
-	int index = 1;
+	size_t index = 1;
 
 	while (index < argc)
 	{
-		const std::string val = argv[index];
+		const std::string& val = args[index];
 
 		if (val == "-o")
 		{
@@ -31,10 +45,10 @@ int main(int argc, char* argv[])
 
 			if (index >= argc)
 			{
-				std::cerr << "\033[1m" << argv[0] << ": \033[31merror: \033[0mMissing filename after '-o'\n";
+				log << "\033[1m" << programName << ": \033[31merror: \033[0mMissing filename after '-o'\n";
 				return -1;
 			}
-			outputFileName = argv[index];
+			outputFileName = args[index];
 		}
 
 		else if (val == "-g")
@@ -46,16 +60,48 @@ int main(int argc, char* argv[])
 
 			if (index >= argc)
 			{
-				std::cerr << "\033[1m" << argv[0] << ": \033[31merror: \033[0mMissing path after '-L'\n";
+				log << "\033[1m" << programName << ": \033[31merror: \033[0mMissing path after '-L'\n";
 				return -1;
 			}
 
-			addPath(argv[index]);
+			addPath(context, args[index]);
+		}
+
+		else if (val == "-j")
+		{
+			index++;
+
+			if (index >= argc)
+			{
+				log << "\033[1m" << programName << ": \033[31merror: \033[0mMissing thread count after '-j'\n";
+				return -1;
+			}
+
+			setThreadCount(std::strtoul(args[index].c_str(), nullptr, 10));
 		}
 
 		else if (val == "--no-main")
 			emitEntryPoint = false;
 
+		else if (val == "--no-lib-cache")
+			setLibraryCacheEnabled(false);
+
+		else if (val == "--no-cache")
+			setCacheEnabled(false);
+
+		else if (val == "-ftime-report" || val == "-ftime-report=json")
+		{
+			timeReport.emplace();
+			context.timeReport = &*timeReport;
+			timeReportJson = val == "-ftime-report=json";
+		}
+
+		else if (val == "-fmem-report")
+		{
+			memReport.emplace();
+			context.memReport = &*memReport;
+		}
+
 		else
 			inputFileName = val;
 
@@ -64,9 +110,145 @@ int main(int argc, char* argv[])
 
 	if (inputFileName.empty())
 	{
-		std::cerr << "\033[1m" << argv[0] << ": \033[31mfatal error: \033[0mNo input filename provided\nCompilation terminated.\n";
+		log << "\033[1m" << programName << ": \033[31mfatal error: \033[0mNo input filename provided\nCompilation terminated.\n";
 		return -1;
 	}
 	
-	compiler(inputFileName, outputFileName, debugSymbols, emitEntryPoint);
+	const bool compiled = compiler(context, inputFileName, outputFileName, debugSymbols, emitEntryPoint);
+	if (!compiled)
+		context.diagnostics.print(log);
+
+	if (timeReport && timeReportJson)
+		timeReport->printJson(log);
+	else if (timeReport)
+		timeReport->print(log);
+	if (memReport)
+		memReport->print(log);
+
+	return compiled ? 0 : -1;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc == 1)
+	{
+		std::cerr << "Invalid number of arguments\n" << "Usage: hexagn file.hxgn or hexagn file.hxgn -o file.urcl (- for stdout)\n"
+			<< "       hexagn --server socket [-L dir]... or hexagn --client socket args...\n"
+			<< "       hexagn --batch list.txt [-j jobs] [--out-dir dir] [--fork] [file.hxgn]... [flags]\n";
+		return -1;
+	}
+
+	const std::vector<std::string> args(argv, argv + argc);
+
+	if (args[1] == "--server" || args[1] == "--client")
+	{
+		if (argc < 3)
+		{
+			std::cerr << "\033[1m" << argv[0] << ": \033[31merror: \033[0mMissing socket path after '" << args[1] << "'\n";
+			return -1;
+		}
+
+		if (args[1] == "--client")
+		{
+			std::vector<std::string> forwarded { args[0] };
+			forwarded.insert(forwarded.end(), args.begin() + 3, args.end());
+			return runClient(args[2], forwarded);
+		}
+
+		// Directories whose library files stay parsed in memory
+		std::vector<std::string> preloadDirs;
+		for (size_t index = 3; index < args.size(); ++index)
+		{
+			if (args[index] != "-L" || index + 1 >= args.size())
+			{
+				std::cerr << "\033[1m" << argv[0] << ": \033[31merror: \033[0mExpected '-L dir' after '--server socket'\n";
+				return -1;
+			}
+			preloadDirs.push_back(args[++index]);
+		}
+
+		return runServer(args[2], preloadDirs, compileCommandLine);
+	}
+
+	if (args[1] == "--batch")
+	{
+		if (argc < 3)
+		{
+			std::cerr << "\033[1m" << argv[0] << ": \033[31merror: \033[0mMissing list file after '--batch'\n";
+			return -1;
+		}
+
+		std::ifstream list(args[2]);
+		if (!list)
+		{
+			std::cerr << "\033[1m" << argv[0] << ": \033[31merror: \033[0mCould not open list file: " << args[2] << '\n';
+			return -1;
+		}
+
+		// One input per line, empty lines are skipped
+		std::vector<std::string> inputs;
+		std::string line;
+		while (std::getline(list, line))
+		{
+			const size_t begin = line.find_first_not_of(" \t\r");
+			if (begin == std::string::npos)
+				continue;
+
+			inputs.push_back(line.substr(begin, line.find_last_not_of(" \t\r") - begin + 1));
+		}
+
+		std::string outputDir;
+		size_t jobs = 0;
+		// Compiles every input in a forked worker, as a guard against crashes
+		bool forkWorkers = false;
+		// Passed on to the compile of every input
+		std::vector<std::string> flags;
+
+		for (size_t index = 3; index < args.size(); ++index)
+		{
+			const std::string& val = args[index];
+
+			if (val == "-j" || val == "--out-dir" || val == "-L")
+			{
+				if (index + 1 >= args.size())
+				{
+					std::cerr << "\033[1m" << argv[0] << ": \033[31merror: \033[0mMissing value after '" << val << "'\n";
+					return -1;
+				}
+				index++;
+
+				if (val == "-j")
+					jobs = std::strtoul(args[index].c_str(), nullptr, 10);
+				else if (val == "--out-dir")
+					outputDir = args[index];
+				else
+					flags.insert(flags.end(), { val, args[index] });
+			}
+
+			else if (val == "--fork")
+				forkWorkers = true;
+
+			else if (val == "-o")
+			{
+				std::cerr << "\033[1m" << argv[0] << ": \033[31merror: \033[0m'-o' cannot be used with '--batch', use '--out-dir'\n";
+				return -1;
+			}
+
+			else if (val.size() > 1 && val[0] == '-')
+				flags.push_back(val);
+
+			else
+				inputs.push_back(val);
+		}
+
+		if (inputs.empty())
+		{
+			std::cerr << "\033[1m" << argv[0] << ": \033[31mfatal error: \033[0mNo input filename provided\nCompilation terminated.\n";
+			return -1;
+		}
+
+		return runBatch(inputs, outputDir, jobs, forkWorkers, flags, compileCommandLine);
+	}
+
+	return compileCommandLine(args, std::cerr);
 }
@@ -0,0 +1,125 @@
+#include <memoryCompile.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <compiler/compiler.h>
+#include <compiler/compilerContext.h>
+#include <compiler/cacheFile.h>
+#include <compiler/outputBuffer.h>
+#include <compiler/symbolTable.h>
+#include <compiler/token.h>
+#include <importer/sourceParser.h>
+
+MemoryCompileResult compileInMemory(const std::string& source, const MemoryLibrary& library, const bool& debugSymbols, const bool& emitEntryPoint)
+{
+	CompilerContext context;
+	context.memoryLibrary = &library;
+	context.src = SourceFile(source);
+
+	OutputBuffer code;
+	MemoryCompileResult result { compileSource(context, code, debugSymbols, emitEntryPoint) };
+	if (result.succeeded)
+		result.urcl = code.toString();
+	result.errors = context.diagnostics.getErrors();
+
+	return result;
+}
+
+static std::string escapeJson(const std::string& str)
+{
+	std::string escaped;
+	escaped.reserve(str.size());
+
+	for (const char& c: str)
+	{
+		switch (c)
+		{
+			case '"':  escaped += "\\\""; break;
+			case '\\': escaped += "\\\\"; break;
+			case '\n': escaped += "\\n"; break;
+			case '\t': escaped += "\\t"; break;
+			case '\r': escaped += "\\r"; break;
+			default:
+				if (uint8_t(c) < 0x20)
+				{
+					char buffer[8];
+					std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+					escaped += buffer;
+				}
+				else
+					escaped += c;
+		}
+	}
+
+	return escaped;
+}
+
+static std::string toJson(const MemoryCompileResult& result)
+{
+	std::string json = "{\"success\":";
+	json += result.succeeded ? "true" : "false";
+	json += ",\"urcl\":\"" + escapeJson(result.urcl) + "\",\"errors\":[";
+
+	for (size_t i = 0; i < result.errors.size(); ++i)
+	{
+		const Diagnostic& error = result.errors[i];
+		if (i != 0)
+			json += ',';
+
+		json += "{\"message\":\"" + escapeJson(error.message) + '"';
+		json += ",\"line\":" + std::to_string(error.lineno);
+		json += ",\"start\":" + std::to_string(error.start);
+		json += ",\"end\":" + std::to_string(error.end);
+		json += ",\"text\":\"" + escapeJson(error.text) + "\"}";
+	}
+
+	return json + "]}";
+}
+
+static MemoryLibrary* createEmbeddedLibrary()
+{
+	// Cache files would go to the virtual filesystem
+	setCacheEnabled(false);
+
+	MemoryLibrary* library = new MemoryLibrary();
+#ifdef HEXAGN_STDLIB_SNAPSHOT
+	for (const EmbeddedLibraryFile* file = stdlibSnapshot; file->path != nullptr; ++file)
+		library->addFile(file->path, file->source);
+#endif
+	return library;
+}
+
+// Library of the WebAssembly entry points, kept for as long as the module is loaded
+static MemoryLibrary& getEmbeddedLibrary()
+{
+	static MemoryLibrary* library = createEmbeddedLibrary();
+	return *library;
+}
+
+void hexagnAddLibraryFile(const char* path, const char* source)
+{
+	getEmbeddedLibrary().addFile(path, source);
+}
+
+void hexagnClearLibraryFiles()
+{
+	getEmbeddedLibrary().clear();
+	clearMemorySources();
+}
+
+const char* hexagnCompile(const char* source, int debugSymbols, int emitEntryPoint)
+{
+	static std::string json;
+	json = toJson(compileInMemory(source, getEmbeddedLibrary(), debugSymbols != 0, emitEntryPoint != 0));
+
+#ifdef __EMSCRIPTEN__
+	// The module lives for the whole session and would otherwise keep every interned
+	// name. Only safe here, a native build may have other compiles still viewing them
+	clearSymbols();
+	clearTokenTexts();
+#endif
+	return json.c_str();
+}
@@ -0,0 +1,324 @@
+#include <server.h>
+
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#include <csignal>
+#include <cerrno>
+#include <unordered_map>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#endif
+
+#include <importer/sourceParser.h>
+
+#if defined(_WIN32) || defined(__EMSCRIPTEN__)
+
+int runServer(const std::string&, const std::vector<std::string>&, CommandLineHandler)
+{
+	std::cerr << "Error: --server is not supported on this platform\n";
+	return -1;
+}
+
+int runClient(const std::string&, const std::vector<std::string>&)
+{
+	std::cerr << "Error: --client is not supported on this platform\n";
+	return -1;
+}
+
+#else
+
+// stdin, stdout and stderr of the client, passed along with the request
+constexpr int STREAM_COUNT = 3;
+
+static bool sendAll(const int& fd, const void* data, size_t size)
+{
+	const char* bytes = static_cast<const char*>(data);
+	while (size > 0)
+	{
+		const ssize_t sent = send(fd, bytes, size, MSG_NOSIGNAL);
+		if (sent < 0 && errno == EINTR) continue;
+		if (sent <= 0) return false;
+
+		bytes += sent;
+		size -= sent;
+	}
+
+	return true;
+}
+
+static bool recvAll(const int& fd, void* data, size_t size)
+{
+	char* bytes = static_cast<char*>(data);
+	while (size > 0)
+	{
+		const ssize_t received = recv(fd, bytes, size, 0);
+		if (received < 0 && errno == EINTR) continue;
+		if (received <= 0) return false;
+
+		bytes += received;
+		size -= received;
+	}
+
+	return true;
+}
+
+static bool makeAddress(const std::string& socketPath, sockaddr_un& address)
+{
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+
+	if (socketPath.size() >= sizeof(address.sun_path))
+	{
+		std::cerr << "Error: Socket path is too long: " << socketPath << '\n';
+		return false;
+	}
+
+	std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+	return true;
+}
+
+// Request layout: the streams as SCM_RIGHTS with a single byte, then
+// uint32 string count, then every string as uint32 size and bytes.
+// The first string is the working directory, the rest the command line
+static bool sendRequest(const int& fd, const std::vector<std::string>& strings)
+{
+	int streams[STREAM_COUNT] = { STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO };
+	char control[CMSG_SPACE(sizeof(streams))] = {};
+	char byte = 0;
+	iovec data { &byte, 1 };
+
+	msghdr message {};
+	message.msg_iov = &data;
+	message.msg_iovlen = 1;
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+
+	cmsghdr* header = CMSG_FIRSTHDR(&message);
+	header->cmsg_level = SOL_SOCKET;
+	header->cmsg_type = SCM_RIGHTS;
+	header->cmsg_len = CMSG_LEN(sizeof(streams));
+	std::memcpy(CMSG_DATA(header), streams, sizeof(streams));
+
+	if (sendmsg(fd, &message, MSG_NOSIGNAL) != 1)
+		return false;
+
+	const uint32_t count = strings.size();
+	if (!sendAll(fd, &count, sizeof(count)))
+		return false;
+
+	for (const std::string& str: strings)
+	{
+		const uint32_t size = str.size();
+		if (!sendAll(fd, &size, sizeof(size)) || !sendAll(fd, str.data(), size))
+			return false;
+	}
+
+	return true;
+}
+
+static bool receiveRequest(const int& fd, int (&streams)[STREAM_COUNT], std::vector<std::string>& strings)
+{
+	char control[CMSG_SPACE(sizeof(streams))] = {};
+	char byte;
+	iovec data { &byte, 1 };
+
+	msghdr message {};
+	message.msg_iov = &data;
+	message.msg_iovlen = 1;
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+
+	if (recvmsg(fd, &message, 0) != 1)
+		return false;
+
+	const cmsghdr* header = CMSG_FIRSTHDR(&message);
+	if (header == nullptr || header->cmsg_type != SCM_RIGHTS || header->cmsg_len != CMSG_LEN(sizeof(streams)))
+		return false;
+	std::memcpy(streams, CMSG_DATA(header), sizeof(streams));
+
+	uint32_t count;
+	if (!recvAll(fd, &count, sizeof(count)))
+		return false;
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		uint32_t size;
+		if (!recvAll(fd, &size, sizeof(size)))
+			return false;
+
+		std::string& str = strings.emplace_back(size, '\0');
+		if (!recvAll(fd, str.data(), size))
+			return false;
+	}
+
+	return !strings.empty();
+}
+
+// Written to by the SIGCHLD handler, so the accept loop wakes up to report finished compiles
+static int childPipe[2];
+
+static void onChildExit(int)
+{
+	const int savedErrno = errno;
+	const char byte = 0;
+	[[maybe_unused]] const ssize_t written = write(childPipe[1], &byte, 1);
+	errno = savedErrno;
+}
+
+// Runs in the forked worker of a connection. The server keeps its end of the
+// connection and sends the worker's exit code once it is done
+[[noreturn]] static void runWorker(const int& fd, CommandLineHandler handler)
+{
+	int streams[STREAM_COUNT];
+	std::vector<std::string> strings;
+	if (!receiveRequest(fd, streams, strings))
+		_exit(-1);
+	close(fd);
+
+	for (int i = 0; i < STREAM_COUNT; ++i)
+	{
+		dup2(streams[i], i);
+		close(streams[i]);
+	}
+
+	if (chdir(strings[0].c_str()) != 0)
+	{
+		std::cerr << "Error: Could not change to directory: " << strings[0] << '\n';
+		exit(-1);
+	}
+
+	// exit flushes the streams the compile wrote to
+	exit(handler(std::vector<std::string>(strings.begin() + 1, strings.end()), std::cerr));
+}
+
+int runServer(const std::string& socketPath, const std::vector<std::string>& preloadDirs, CommandLineHandler handler)
+{
+	sockaddr_un address;
+	if (!makeAddress(socketPath, address))
+		return -1;
+
+	for (const std::string& dir: preloadDirs)
+		preloadLibraryFiles(dir);
+
+	const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(socketPath.c_str());
+	if (listener < 0 || bind(listener, (const sockaddr*) &address, sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0)
+	{
+		std::cerr << "Error: Could not listen on socket: " << socketPath << '\n';
+		return -1;
+	}
+
+	if (pipe(childPipe) != 0)
+	{
+		std::cerr << "Error: Could not create pipe\n";
+		return -1;
+	}
+	fcntl(childPipe[0], F_SETFL, O_NONBLOCK);
+	fcntl(childPipe[1], F_SETFL, O_NONBLOCK);
+
+	struct sigaction action {};
+	action.sa_handler = onChildExit;
+	action.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+	sigaction(SIGCHLD, &action, nullptr);
+
+	// Client connection of every running worker
+	std::unordered_map<pid_t, int> connections;
+
+	while (true)
+	{
+		pollfd fds[2] = { { listener, POLLIN, 0 }, { childPipe[0], POLLIN, 0 } };
+		if (poll(fds, 2, -1) < 0)
+		{
+			if (errno == EINTR) continue;
+
+			std::cerr << "Error: Could not poll socket: " << socketPath << '\n';
+			return -1;
+		}
+
+		if (fds[1].revents & POLLIN)
+		{
+			char bytes[64];
+			while (read(childPipe[0], bytes, sizeof(bytes)) > 0);
+
+			int waitStatus;
+			pid_t worker;
+			while ((worker = waitpid(-1, &waitStatus, WNOHANG)) > 0)
+			{
+				const auto it = connections.find(worker);
+				if (it == connections.end())
+					continue;
+
+				const int32_t status = WIFEXITED(waitStatus) ? WEXITSTATUS(waitStatus) : -1;
+				sendAll(it->second, &status, sizeof(status));
+				close(it->second);
+				connections.erase(it);
+			}
+		}
+
+		if (fds[0].revents & POLLIN)
+		{
+			const int fd = accept(listener, nullptr, nullptr);
+			if (fd < 0)
+				continue;
+
+			const pid_t worker = fork();
+			if (worker == 0)
+			{
+				close(listener);
+				close(childPipe[0]);
+				close(childPipe[1]);
+				for (const auto& [_, connection]: connections)
+					close(connection);
+
+				signal(SIGCHLD, SIG_DFL);
+				runWorker(fd, handler);
+			}
+
+			if (worker < 0)
+				close(fd);
+			else
+				connections.emplace(worker, fd);
+		}
+	}
+}
+
+int runClient(const std::string& socketPath, const std::vector<std::string>& args)
+{
+	sockaddr_un address;
+	if (!makeAddress(socketPath, address))
+		return -1;
+
+	const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0 || connect(fd, (const sockaddr*) &address, sizeof(address)) != 0)
+	{
+		std::cerr << "Error: Could not connect to compile server: " << socketPath << '\n';
+		return -1;
+	}
+
+	std::vector<std::string> strings;
+	char cwd[4096];
+	strings.push_back(getcwd(cwd, sizeof(cwd)) ? cwd : ".");
+	strings.insert(strings.end(), args.begin(), args.end());
+
+	int32_t status;
+	if (!sendRequest(fd, strings) || !recvAll(fd, &status, sizeof(status)))
+	{
+		std::cerr << "Error: Lost connection to compile server: " << socketPath << '\n';
+		close(fd);
+		return -1;
+	}
+
+	close(fd);
+	return status;
+}
+
+#endif
@@ -2,6 +2,14 @@
 #include <string>
 #include <vector>
 #include <sstream>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#include <pthread.h>
+#endif
 
 #include <util.h>
 
@@ -45,33 +53,18 @@ std::vector<std::string> split(std::string str, char sep)
 	return res;
 }
 
-void drawArrows(size_t start, size_t end, const size_t& lineno)
+std::string getArrows(size_t start, size_t end, const size_t& lineno)
 {
 	// Offset due to adding line number on the left
 	const size_t& offset = std::to_string(lineno).length() + 2;
 	start += offset;
 	end   += offset;
 
-	std::cerr << "\033[31m";
-	for (size_t i = 0; i < start; ++i)	  std::cerr << ' ';
-	for (size_t i = start; i <= end; ++i)   std::cerr << '^';
-	std::cerr << "\033[0m\n";
-}
-
-size_t find_nth(std::string haystack, const char& needle, const size_t& nth)
-{
-	std::string read;
-	for (size_t i = 1; i < nth + 1; ++i)
-	{
-		size_t found = haystack.find(needle);
-		read += haystack.substr(0, found + 1);
-		haystack.erase(0, found + 1);
-
-		if (i == nth)
-			return read.size();
-	}
-
-	return -1;
+	std::string arrows = "\033[31m";
+	for (size_t i = 0; i < start; ++i)	  arrows += ' ';
+	for (size_t i = start; i <= end; ++i)   arrows += '^';
+	arrows += "\033[0m\n";
+	return arrows;
 }
 
 const bool isIntegerDataType(const Token& tok)
@@ -89,16 +82,202 @@ const bool isNumber(const Token& tok)
 	return tok.m_type == TokenType::TT_NUM || tok.m_type == TokenType::TT_FLT;
 }
 
-const std::string getSourceLine(const std::string& src, const size_t& line)
+const bool isOperator(const Token& tok)
 {
-	std::string ret;
-	ret += line + ": ";
-	for (size_t i = find_nth(src, '\n', line - 1); src[i] != '\n'; ++i)
-		ret += src[i];
+	switch (tok.m_type)
+	{
+		case TokenType::TT_PLUS:
+		case TokenType::TT_MINUS:
+		case TokenType::TT_MULT:
+		case TokenType::TT_DIV:
+		case TokenType::TT_MOD:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+const bool isDataType(const Token& tok)
+{
+	return tok.m_type == TokenType::TT_VOID
+			|| tok.m_type == TokenType::TT_INT
+			|| tok.m_type == TokenType::TT_UINT
+			|| tok.m_type == TokenType::TT_FLOAT
+			|| tok.m_type == TokenType::TT_STRING
+			|| tok.m_type == TokenType::TT_CHARACTER;
+}
+
+const bool isComparison(const Token& tok)
+{
+	return tok.m_type == TokenType::TT_EQ
+			|| tok.m_type == TokenType::TT_NEQ
+			|| tok.m_type == TokenType::TT_GT
+			|| tok.m_type == TokenType::TT_GTE
+			|| tok.m_type == TokenType::TT_LT
+			|| tok.m_type == TokenType::TT_LTE;
+}
+
+const std::string getSourceLine(const SourceFile& src, const size_t& line)
+{
+	std::string ret(src.getLine(line));
+
+	// Columns count tabs as a single character, print them as one so arrows line up
+	std::replace(ret.begin(), ret.end(), '\t', ' ');
+	if (!ret.empty() && ret.back() == '\r')
+		ret.pop_back();
+
 	ret += '\n';
 	return ret;
 }
 
+uint64_t hashBytes(std::string_view data)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (const char& c: data)
+	{
+		hash ^= uint8_t(c);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+static size_t threadCount = 0;
+
+void setThreadCount(const size_t& count)
+{
+	threadCount = count;
+}
+
+// A parallelFor call, the pool's threads help the calling thread with it
+struct ParallelJob
+{
+	const std::function<void(size_t)>& body;
+	const size_t count;
+	// Pool threads that may run indices of the job at once
+	const size_t maxHelpers;
+
+	size_t helpers = 0;
+	size_t next = 0;
+	size_t done = 0;
+};
+
+// Threads shared by every parallelFor call, started when first needed and kept
+// for the rest of the process. Calls can nest and come from several threads,
+// each caller runs indices of its own job until none are left to claim
+class WorkerPool
+{
+private:
+	std::mutex m_mutex;
+	std::condition_variable m_work;
+	std::condition_variable m_finished;
+	// Jobs that still have indices to claim, oldest first
+	std::vector<ParallelJob*> m_jobs;
+	size_t m_threads = 0;
+
+	// Takes the next index of a job, the job leaves m_jobs once its last one is taken
+	size_t claim(ParallelJob& job)
+	{
+		const size_t index = job.next++;
+		if (job.next == job.count)
+			std::erase(m_jobs, &job);
+		return index;
+	}
+
+	ParallelJob* findJob()
+	{
+		for (ParallelJob* job: m_jobs)
+			if (job->helpers < job->maxHelpers)
+				return job;
+		return nullptr;
+	}
+
+	void runWorker()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (true)
+		{
+			ParallelJob* job = nullptr;
+			m_work.wait(lock, [this, &job]() { return (job = findJob()) != nullptr; });
+
+			const size_t index = claim(*job);
+			job->helpers++;
+
+			lock.unlock();
+			job->body(index);
+			lock.lock();
+
+			job->helpers--;
+			// The caller returns and drops the job once the last index is done
+			if (++job->done == job->count)
+				m_finished.notify_all();
+		}
+	}
+
+public:
+	void run(ParallelJob& job)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		for (; m_threads < job.maxHelpers; ++m_threads)
+			std::thread(&WorkerPool::runWorker, this).detach();
+
+		m_jobs.push_back(&job);
+		m_work.notify_all();
+
+		while (job.next < job.count)
+		{
+			const size_t index = claim(job);
+
+			lock.unlock();
+			job.body(index);
+			lock.lock();
+
+			job.done++;
+		}
+
+		m_finished.wait(lock, [&job]() { return job.done == job.count; });
+	}
+};
+
+static WorkerPool* workerPool = nullptr;
+static std::mutex workerPoolMutex;
+
+// Never destroyed, its threads run until the process exits
+static WorkerPool& getWorkerPool()
+{
+	std::lock_guard<std::mutex> lock(workerPoolMutex);
+	if (workerPool == nullptr)
+	{
+		workerPool = new WorkerPool();
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+		// A forked child has none of the threads, it starts a pool of its own when it needs one
+		static const int registered = pthread_atfork(nullptr, nullptr, []() { workerPool = nullptr; });
+		(void) registered;
+#endif
+	}
+	return *workerPool;
+}
+
+void parallelFor(const size_t& count, const std::function<void(size_t)>& body)
+{
+#ifdef __EMSCRIPTEN__
+	// No threads without pthread support in the WebAssembly build
+	const size_t threads = 1;
+#else
+	const size_t threads = std::min<size_t>(count, threadCount != 0 ? threadCount : std::max(1u, std::thread::hardware_concurrency()));
+#endif
+
+	if (threads <= 1)
+	{
+		for (size_t i = 0; i < count; ++i)
+			body(i);
+		return;
+	}
+
+	ParallelJob job { body, count, threads - 1 };
+	getWorkerPool().run(job);
+}
+
 namespace std
 {
 	// Overload of to_string for TokenType input